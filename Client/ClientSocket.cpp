@@ -20,6 +20,7 @@ void ClientSocket::connectToServer(QString ip, int port, QString nickName, QStri
 
     // 如果之前连着，先断开，防止状态混乱
     m_socket->abort();
+    m_recvBuffer.clear();
     // 发起连接
     m_socket->connectToHost(ip, port);
 }
@@ -27,7 +28,10 @@ void ClientSocket::connectToServer(QString ip, int port, QString nickName, QStri
 void ClientSocket::sendMsg(QString msg)
 {
     if (m_socket->isOpen() && !msg.isEmpty()) {
-        m_socket->write(msg.toUtf8());
+        // 换行是帧分隔符，消息内部不允许出现
+        QString line = msg;
+        line.replace('\n', ' ');
+        m_socket->write(line.toUtf8() + '\n');
         m_socket->flush(); // 立即发送
     }
 }
@@ -38,7 +42,7 @@ void ClientSocket::onConnected()
     // 以前：只发送名字 m_socket->write(m_myNickName.toUtf8());
     // 现在：发送 CMD:LOGIN|Name|Password
     if (m_socket->isOpen()) {
-        QString loginPacket = "CMD:LOGIN|" + m_myNickName + "|" + m_myPassword;
+        QString loginPacket = "CMD:LOGIN|" + m_myNickName + "|" + m_myPassword + "\n";
         m_socket->write(loginPacket.toUtf8());
         m_socket->flush();
 
@@ -54,8 +58,28 @@ void ClientSocket::onDisconnected()
 
 void ClientSocket::onReadyRead()
 {
-    // 读取所有数据
-    QByteArray data = m_socket->readAll();
-    // 转为 QString 并通知 UI 显示
-    emit msgReceived(QString::fromUtf8(data));
-}
\ No newline at end of file
+    // 追加到重组缓冲区，只把完整的行交给 UI，半行留到下次
+    m_recvBuffer.append(m_socket->readAll());
+
+    QList<QByteArray> frames;
+    int start = 0;
+    int pos;
+    while ((pos = m_recvBuffer.indexOf('\n', start)) != -1) {
+        QByteArray line = m_recvBuffer.mid(start, pos - start);
+        if (line.endsWith('\r')) line.chop(1);
+        if (!line.isEmpty()) frames.append(line);
+        start = pos + 1;
+    }
+    m_recvBuffer.remove(0, start);
+
+    if (m_recvBuffer.size() > kMaxFrame) {
+        m_recvBuffer.clear();
+        m_socket->abort();
+        return;
+    }
+
+    // 先切完再逐条通知，避免槽函数里弹窗重入时打乱缓冲区
+    for (const QByteArray& frame : frames) {
+        emit msgReceived(QString::fromUtf8(frame));
+    }
+}
\ No newline at end of file
@@ -11,7 +11,7 @@ public:
     // 【修改】连接服务器 (增加 password 参数)
     void connectToServer(QString ip, int port, QString nickName, QString password);
 
-    // 发送消息 (通用方法)
+    // 发送消息 (通用方法)，每条消息以 '\n' 结尾作为帧边界
     void sendMsg(QString msg);
 
 signals:
@@ -34,4 +34,8 @@ private:
     QTcpSocket* m_socket;
     QString m_myNickName; // 暂存昵称
     QString m_myPassword; // 【新增】暂存密码
-};
\ No newline at end of file
+
+    // 接收重组缓冲区：TCP 不保证一次 readyRead 恰好是一条消息
+    QByteArray m_recvBuffer;
+    static const int kMaxFrame = 4 * 1024 * 1024;
+};
\ No newline at end of file
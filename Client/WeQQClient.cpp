@@ -5,6 +5,7 @@
 #include <QTextStream>
 #include <QTextBlock>
 #include <QSet>
+#include <QScrollBar>
 
 // ====================================================================
 // 构造与析构
@@ -59,9 +60,21 @@ WeQQClient::WeQQClient(QWidget* parent) : QWidget(parent) {
 
     connect(ui.tabWidget, &QTabWidget::currentChanged, this, &WeQQClient::onTabChanged);
 
+    // 【新增】搜索框群名补全，输入停顿 200ms 后再查询，避免每个按键都发一次请求
+    m_groupCompleterModel = new QStringListModel(this);
+    m_groupCompleter = new QCompleter(m_groupCompleterModel, this);
+    m_groupCompleter->setCaseSensitivity(Qt::CaseSensitive);
+    ui.leSearch->setCompleter(m_groupCompleter);
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(200);
+    connect(m_searchTimer, &QTimer::timeout, this, &WeQQClient::requestGroupSearch);
+    connect(ui.leSearch, &QLineEdit::textEdited, this, &WeQQClient::onSearchEdited);
+
     // 【新增】聊天窗口右键菜单
     ui.browserChat->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui.browserChat, &QTextBrowser::customContextMenuRequested, this, &WeQQClient::onChatContextMenu);
+    connect(ui.browserChat->verticalScrollBar(), &QScrollBar::valueChanged, this, &WeQQClient::onChatScrolled);
 
     // 【核心】动态创建指令按钮
     m_btnCmd = new QPushButton("输入指令", ui.widget_2);
@@ -167,6 +180,7 @@ void WeQQClient::on_btnCmd_clicked() {
 
     ui.browserChat->clear();
     m_blockToUuid.clear();
+    resetHistoryState();
 
     ui.labelChatTitle->setText(">>> 指令模式 (直接发送Server) <<<");
     ui.browserChat->append(">>> 已进入指令模式。");
@@ -255,6 +269,31 @@ void WeQQClient::onMsgReceived(QString rawMsg) {
         if (cleanLine == "CMD:CLEAR_CHAT") {
             ui.browserChat->clear();
             m_blockToUuid.clear();
+            resetHistoryState();
+            continue;
+        }
+
+        // 【新增】HISTORY_BEGIN|类型|会话ID|下一页游标 ... HISTORY_END|类型|会话ID
+        if (cleanLine.startsWith("CMD:HISTORY_BEGIN|")) {
+            QStringList parts = cleanLine.mid(18).split('|');
+            if (parts.size() >= 3 && parts[0].toInt() == m_currentType && parts[1].toInt() == m_currentSessionId) {
+                m_inHistoryPage = true;
+                m_historyCursor = parts[2];
+                m_pageLines.clear();
+                m_pageUuids.clear();
+            }
+            continue;
+        }
+
+        if (cleanLine.startsWith("CMD:HISTORY_END|")) {
+            QStringList parts = cleanLine.mid(16).split('|');
+            if (m_inHistoryPage && parts.size() >= 2 && parts[0].toInt() == m_currentType && parts[1].toInt() == m_currentSessionId) {
+                m_inHistoryPage = false;
+                flushHistoryPage();
+                m_historyLoading = false;
+                // 第一页不够撑出滚动条时用户无法触发翻页，直接接着取
+                if (ui.browserChat->verticalScrollBar()->maximum() == 0) requestOlderHistory();
+            }
             continue;
         }
 
@@ -275,6 +314,10 @@ void WeQQClient::onMsgReceived(QString rawMsg) {
             parseGroupList(cleanLine.mid(15));
             continue;
         }
+        if (cleanLine.startsWith("CMD:GROUP_SEARCH|")) {
+            parseGroupSearch(cleanLine.mid(17));
+            continue;
+        }
 
         if (cleanLine.startsWith("CMD:GROUP_MEMBERS|")) {
             QString body = cleanLine.mid(18);
@@ -359,27 +402,24 @@ void WeQQClient::onMsgReceived(QString rawMsg) {
             QStringList reqs = body.split(';', Qt::SkipEmptyParts);
             for (const QString& r : reqs) {
                 QStringList parts = r.split(',');
-                if (parts.size() >= 4) {
-                    QString type = parts[0];
-                    QString fromId = parts[1];
-                    QString fromName = parts[2];
-                    QString targetId = parts[3];
-                    QString displayText;
-                    if (type == "FRIEND") {
-                        displayText = QString("好友申请: [%1] (%2)").arg(fromName).arg(fromId);
-                    }
-                    else {
-                        displayText = QString("入群申请: [%1] -> 群 %2").arg(fromName).arg(targetId);
-                    }
-                    QListWidgetItem* item = new QListWidgetItem(displayText);
-                    QString meta = type + "|" + fromId + "|" + targetId;
-                    item->setData(Qt::UserRole, meta);
-                    m_listRequests->addItem(item);
-                }
+                if (parts.size() >= 4) addRequestItem(parts[0], parts[1], parts[2], parts[3]);
             }
             continue;
         }
 
+        // 【新增】申请列表增量：ADDED 类型,申请人ID,申请人名,目标ID；REMOVED 类型,申请人ID,目标ID
+        if (cleanLine.startsWith("CMD:REQUEST_ADDED|")) {
+            QStringList parts = cleanLine.mid(18).split(',');
+            if (parts.size() >= 4) addRequestItem(parts[0], parts[1], parts[2], parts[3]);
+            continue;
+        }
+
+        if (cleanLine.startsWith("CMD:REQUEST_REMOVED|")) {
+            QStringList parts = cleanLine.mid(20).split(',');
+            if (parts.size() >= 3) removeRequestItem(parts[0] + "|" + parts[1] + "|" + parts[2]);
+            continue;
+        }
+
         if (cleanLine.startsWith("MSG:")) {
             QString body = cleanLine.mid(4);
             QStringList parts = body.split('|');
@@ -425,6 +465,11 @@ void WeQQClient::onMsgReceived(QString rawMsg) {
 
                 if (m_currentSessionId == targetId && m_currentType == type) {
                     QString lineMsg = QString("[%1] %2: %3").arg(time).arg(sender).arg(displayContent);
+                    if (m_inHistoryPage) {
+                        m_pageLines.append(lineMsg);
+                        m_pageUuids.append(uuid);
+                        continue;
+                    }
                     ui.browserChat->append(lineMsg);
 
                     int blockId = ui.browserChat->document()->blockCount() - 1;
@@ -579,6 +624,7 @@ void WeQQClient::on_listFriends_itemClicked(QListWidgetItem* item) {
 
     ui.browserChat->clear();
     m_blockToUuid.clear();
+    resetHistoryState();
 
     m_client->sendMsg("CMD:ENTER_FRIEND|" + QString::number(uid));
 }
@@ -607,6 +653,7 @@ void WeQQClient::on_listGroups_itemClicked(QListWidgetItem* item) {
 
     ui.browserChat->clear();
     m_blockToUuid.clear();
+    resetHistoryState();
 
     m_client->sendMsg("CMD:ENTER_GROUP|" + QString::number(gid));
     m_client->sendMsg("CMD:REQ_GROUP_MEMBERS|" + QString::number(gid));
@@ -626,10 +673,79 @@ void WeQQClient::on_btnRequestList_clicked() {
     ui.labelChatTitle->setText("处理请求中...");
     ui.browserChat->clear();
     m_blockToUuid.clear();
+    resetHistoryState();
 
     m_client->sendMsg("CMD:ENTER_REQUEST_LIST");
 }
 
+// ====================================================================
+// 分页历史
+// ====================================================================
+
+void WeQQClient::resetHistoryState() {
+    m_historyCursor = "0";
+    m_historyLoading = false;
+    m_inHistoryPage = false;
+    m_pageLines.clear();
+    m_pageUuids.clear();
+}
+
+void WeQQClient::onChatScrolled(int value) {
+    if (value == ui.browserChat->verticalScrollBar()->minimum()) requestOlderHistory();
+}
+
+void WeQQClient::requestOlderHistory() {
+    if (m_isCommandMode || m_currentSessionId == -1 || m_historyLoading || m_historyCursor == "0") return;
+    m_historyLoading = true;
+    m_client->sendMsg(QString("CMD:HISTORY|%1|%2|%3|50").arg(m_currentType).arg(m_currentSessionId).arg(m_historyCursor));
+}
+
+// 把攒下的一页插到最前面：这一页一定早于窗口里已有的消息 (包括等待期间收到的新消息)
+void WeQQClient::flushHistoryPage() {
+    QSet<QString> shown;
+    for (const QString& u : m_blockToUuid) shown.insert(u);
+
+    QStringList lines, uuids;
+    for (int i = 0; i < m_pageLines.size(); ++i) {
+        if (shown.contains(m_pageUuids[i])) continue;
+        lines.append(m_pageLines[i]);
+        uuids.append(m_pageUuids[i]);
+    }
+    m_pageLines.clear();
+    m_pageUuids.clear();
+    if (lines.isEmpty()) return;
+
+    QTextDocument* doc = ui.browserChat->document();
+    if (doc->isEmpty()) {
+        for (int i = 0; i < lines.size(); ++i) {
+            ui.browserChat->append(lines[i]);
+            m_blockToUuid[doc->blockCount() - 1] = uuids[i];
+        }
+        return;
+    }
+
+    QScrollBar* bar = ui.browserChat->verticalScrollBar();
+    int oldMax = bar->maximum();
+    int oldValue = bar->value();
+
+    QTextCursor cursor(doc);
+    cursor.movePosition(QTextCursor::Start);
+    for (const QString& line : lines) {
+        cursor.insertText(line);
+        cursor.insertBlock();
+    }
+
+    // 原有块号整体后移
+    int n = lines.size();
+    QMap<int, QString> shifted;
+    for (auto it = m_blockToUuid.constBegin(); it != m_blockToUuid.constEnd(); ++it) shifted[it.key() + n] = it.value();
+    for (int i = 0; i < n; ++i) shifted[i] = uuids[i];
+    m_blockToUuid.swap(shifted);
+
+    // 保持用户正在看的位置不动
+    bar->setValue(oldValue + bar->maximum() - oldMax);
+}
+
 // ====================================================================
 // 右键菜单逻辑
 // ====================================================================
@@ -707,6 +823,33 @@ void WeQQClient::on_listGroupMembers_customContextMenuRequested(const QPoint& po
     delete menu;
 }
 
+void WeQQClient::addRequestItem(const QString& type, const QString& fromId, const QString& fromName, const QString& targetId) {
+    QString meta = type + "|" + fromId + "|" + targetId;
+    for (int i = 0; i < m_listRequests->count(); ++i) {
+        if (m_listRequests->item(i)->data(Qt::UserRole).toString() == meta) return;
+    }
+
+    QString displayText;
+    if (type == "FRIEND") {
+        displayText = QString("好友申请: [%1] (%2)").arg(fromName).arg(fromId);
+    }
+    else {
+        displayText = QString("入群申请: [%1] -> 群 %2").arg(fromName).arg(targetId);
+    }
+    QListWidgetItem* item = new QListWidgetItem(displayText);
+    item->setData(Qt::UserRole, meta);
+    m_listRequests->addItem(item);
+}
+
+void WeQQClient::removeRequestItem(const QString& meta) {
+    for (int i = 0; i < m_listRequests->count(); ++i) {
+        if (m_listRequests->item(i)->data(Qt::UserRole).toString() == meta) {
+            delete m_listRequests->takeItem(i);
+            return;
+        }
+    }
+}
+
 void WeQQClient::on_listRequests_customContextMenuRequested(const QPoint& pos) {
     QListWidgetItem* item = m_listRequests->itemAt(pos);
     if (!item) return;
@@ -737,8 +880,43 @@ void WeQQClient::on_btnJoinGroup_clicked() {
     if (!target.isEmpty()) m_client->sendMsg("/g_join " + target);
     ui.leSearch->clear();
 }
+void WeQQClient::onSearchEdited(const QString& text) {
+    // 纯数字按群号/用户 ID 处理，不做名字补全
+    QString prefix = text.trimmed();
+    bool isNumber = false;
+    prefix.toInt(&isNumber);
+    if (prefix.isEmpty() || isNumber) {
+        m_searchTimer->stop();
+        m_groupCompleterModel->setStringList(QStringList());
+        return;
+    }
+    m_searchTimer->start();
+}
+
+void WeQQClient::requestGroupSearch() {
+    QString prefix = ui.leSearch->text().trimmed();
+    if (prefix.isEmpty()) return;
+    m_client->sendMsg("CMD:GROUP_SEARCH|" + prefix + "|10");
+}
+
+// 格式：前缀|ID,群名;ID,群名;...
+void WeQQClient::parseGroupSearch(QString data) {
+    int sep = data.lastIndexOf('|');
+    if (sep < 0) return;
+    // 输入已经变了，丢弃过期结果
+    if (data.left(sep) != ui.leSearch->text().trimmed()) return;
+
+    QStringList names;
+    for (const QString& g : data.mid(sep + 1).split(';', Qt::SkipEmptyParts)) {
+        int comma = g.indexOf(',');
+        if (comma > 0) names << g.mid(comma + 1);
+    }
+    m_groupCompleterModel->setStringList(names);
+    if (!names.isEmpty() && ui.leSearch->hasFocus()) m_groupCompleter->complete();
+}
+
 void WeQQClient::on_btnCreateGroup_clicked() {
     QString name = ui.leSearch->text().trimmed();
     if (!name.isEmpty()) m_client->sendMsg("/g_create " + name);
     ui.leSearch->clear();
-}
\ No newline at end of file
+}
\ No newline at end of file
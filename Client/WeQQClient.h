@@ -10,6 +10,9 @@
 #include <QMenu>
 #include <QPushButton>
 #include <QMap> 
+#include <QCompleter>
+#include <QStringListModel>
+#include <QTimer>
 
 class WeQQClient : public QWidget
 {
@@ -45,6 +48,11 @@ private slots:
     void on_listRequests_customContextMenuRequested(const QPoint& pos);
     // 【新增】聊天记录右键菜单
     void onChatContextMenu(const QPoint& pos);
+    // 【新增】滚动到顶部时加载更早的历史
+    void onChatScrolled(int value);
+    // 【新增】搜索框输入停顿后按前缀向服务器查群名
+    void onSearchEdited(const QString& text);
+    void requestGroupSearch();
 
     // --- 网络回调 ---
     void onMsgReceived(QString msg);
@@ -67,6 +75,13 @@ private:
     // 【新增】BlockNumber -> UUID 映射
     QMap<int, QString> m_blockToUuid;
 
+    // 【新增】分页历史：服务器按页下发，HISTORY_BEGIN/END 之间的消息先攒起来再一次插入
+    QString m_historyCursor = "0";   // 下一页的 beforeId，"0" 表示没有更早的记录
+    bool m_historyLoading = false;   // 已请求、尚未收到 HISTORY_END
+    bool m_inHistoryPage = false;
+    QStringList m_pageLines;
+    QStringList m_pageUuids;
+
     QString m_privateRecordRoot;
     QString m_groupRecordRoot;
 
@@ -76,6 +91,11 @@ private:
     QListWidget* m_listRequests;
     QWidget* m_tabRequests;
 
+    // 【新增】搜索框的群名补全：结果来自 CMD:GROUP_SEARCH，不再拉全服群列表
+    QCompleter* m_groupCompleter;
+    QStringListModel* m_groupCompleterModel;
+    QTimer* m_searchTimer;
+
     void appendLog(QString msg);
 
     void parseUserList(QString data);
@@ -83,10 +103,18 @@ private:
     void updateOnlineStatus(QString data);
 
     void parseGroupList(QString data);
+    void parseGroupSearch(QString data);
     void parseFriendAdd(QString data);
+    // 【新增】申请列表按 "类型|申请人ID|目标ID" 增删一项
+    void addRequestItem(const QString& type, const QString& fromId, const QString& fromName, const QString& targetId);
+    void removeRequestItem(const QString& meta);
     void parseLoginSuccess(QString data);
 
+    void resetHistoryState();
+    void requestOlderHistory();
+    void flushHistoryPage();
+
     void checkAndInitFolders();
     QString getPrivateChatFilePath(QString friendName, int friendId);
     QString getGroupChatFilePath(QString groupName);
-};
\ No newline at end of file
+};
\ No newline at end of file
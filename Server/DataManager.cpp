@@ -1,9 +1,13 @@
 ﻿#include "DataManager.h"
+#include "JournalReader.h"
 #include <sstream>
+#include <filesystem>
+#include <algorithm>
 
 // 构造函数
 DataManager::DataManager(string filename, FileType type)
-    : m_filename(filename), m_type(type), m_autoSaveEnabled(true), m_maxId(1000)
+    : m_filename(filename), m_type(type), m_autoSaveEnabled(true), m_maxId(1000),
+      m_journalName(filename + ".journal")
 {
     // 构造时直接根据类型加载数据
     load();
@@ -22,27 +26,73 @@ void DataManager::setAutoSave(bool enable) {
 }
 
 // --- 用户操作 ---
-void DataManager::addUser(const User& user) {
+bool DataManager::addUser(const User& user) {
     if (m_type != TYPE_USER) {
         cout << "Warning: Trying to add User to a Log file!" << endl;
-        return;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_idIndex.count(user.getId()) || m_nameIndex.count(user.getUsername())) {
+        return false;
     }
     if (user.getId() > m_maxId) {
         m_maxId = user.getId();
     }
     m_users.push_back(user);
+    m_idIndex[user.getId()] = m_users.size() - 1;
+    m_nameIndex[user.getUsername()] = m_users.size() - 1;
 
-    // 【修改点】每次更新数据立即保存
+    // 【修改】只向日志追加一行，不再整表重写 Users.txt
     if (m_autoSaveEnabled) {
-        save();
+        appendJournalLocked(user);
+        size_t snapshotUsers = m_users.size() > m_journalRecords ? m_users.size() - m_journalRecords : 0;
+        if (m_journalRecords > std::max(kCompactMin, snapshotUsers)) {
+            saveLocked();
+        }
     }
+    return true;
+}
+
+// 调用方需已持有 m_mutex
+bool DataManager::appendJournalLocked(const User& user) {
+    if (!m_journal.is_open()) {
+        m_journal.open(m_journalName, ios::out | ios::app | ios::binary);
+        if (!m_journal.is_open()) return false;
+    }
+    string line = user.toString() + "\n";
+    m_journal.write(line.data(), (streamsize)line.size());
+    m_journal.flush();
+    m_bytesWritten += line.size();
+    m_journalRecords++;
+    return m_journal.good();
 }
 
 vector<User> DataManager::getAllUsers() const {
-    return m_users;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return vector<User>(m_users.begin(), m_users.end());
+}
+
+const User* DataManager::findById(int id) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_idIndex.find(id);
+    if (it == m_idIndex.end()) return nullptr;
+    return &m_users[it->second];
+}
+
+const User* DataManager::findByName(const string& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_nameIndex.find(name);
+    if (it == m_nameIndex.end()) return nullptr;
+    return &m_users[it->second];
+}
+
+size_t DataManager::getUserCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_users.size();
 }
 
 int DataManager::getNextId() {
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_maxId++; // 自增
     return m_maxId;
 }
@@ -53,11 +103,12 @@ void DataManager::addLog(string logInfo) {
         cout << "Warning: Trying to add Log to a User file!" << endl;
         return;
     }
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_logs.push_back(logInfo);
 
     // 【修改点】每次更新数据立即保存
     if (m_autoSaveEnabled) {
-        save();
+        saveLocked();
     }
 }
 
@@ -66,26 +117,51 @@ void DataManager::addLog(string logInfo) {
 // ----------------------------------------
 
 bool DataManager::save() {
-    // 1. 打开文件 (覆盖模式 user 用，追加模式 log 用？这里为了简单统一用覆盖/截断)
-    ofstream ofs(m_filename, ios::out | ios::trunc);
-
-    if (!ofs.is_open()) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return saveLocked();
+}
 
-    // 2. 根据类型写入不同的数据
+// 调用方需已持有 m_mutex
+bool DataManager::saveLocked() {
     if (m_type == TYPE_USER) {
-        // --- 写用户模式 ---
+        // --- 写用户模式：先写临时快照再替换，中途崩溃时旧快照 + 日志仍然完整 ---
+        string tmpName = m_filename + ".tmp";
+        ofstream ofs(tmpName, ios::out | ios::trunc | ios::binary);
+        if (!ofs.is_open()) return false;
+
+        string buf;
         for (const auto& user : m_users) {
             // User::toString 现在已经包含了密码
-            ofs << user.toString() << endl;
-        }
-    }
-    else if (m_type == TYPE_LOG) {
-        // --- 写日志模式 ---
-        for (const auto& log : m_logs) {
-            ofs << log << endl;
+            buf += user.toString();
+            buf += '\n';
+            if (buf.size() >= 64 * 1024) {
+                ofs.write(buf.data(), (streamsize)buf.size());
+                m_bytesWritten += buf.size();
+                buf.clear();
+            }
         }
+        ofs.write(buf.data(), (streamsize)buf.size());
+        m_bytesWritten += buf.size();
+        ofs.close();
+        if (ofs.fail()) return false;
+
+        std::error_code ec;
+        std::filesystem::rename(tmpName, m_filename, ec);
+        if (ec) return false;
+
+        // 快照已包含全部记录，日志可以清空
+        if (m_journal.is_open()) m_journal.close();
+        m_journal.open(m_journalName, ios::out | ios::trunc | ios::binary);
+        m_journalRecords = 0;
+        return true;
     }
 
+    // --- 写日志模式 ---
+    ofstream ofs(m_filename, ios::out | ios::trunc);
+    if (!ofs.is_open()) return false;
+    for (const auto& log : m_logs) {
+        ofs << log << endl;
+    }
     ofs.close();
     // cout << ">> Saved data to " << m_filename << endl; // 注释掉避免刷屏
     return true;
@@ -95,43 +171,62 @@ bool DataManager::save() {
 // --- 核心读取逻辑 ---
 // ----------------------------------------
 
-bool DataManager::load() {
-    ifstream ifs(m_filename);
-    if (!ifs.is_open()) return true; // 文件不存在
+// 调用方需已持有 m_mutex；解析一行 "ID Name Password IP"
+bool DataManager::parseUserLine(const string& line) {
+    stringstream ss(line);
+    int id;
+    string u, p, i;
+    // 确保能读到 4 个字段 (日志末尾被截断的半行会在这里被丢弃)
+    if (!(ss >> id >> u >> p >> i)) return false;
+    // 重复的 ID/用户名只保留第一条，保证索引一一对应
+    if (m_idIndex.count(id) || m_nameIndex.count(u)) return false;
+
+    m_users.push_back(User(id, u, p, i));
+    m_idIndex[id] = m_users.size() - 1;
+    m_nameIndex[u] = m_users.size() - 1;
+    if (id > m_maxId) {
+        m_maxId = id;
+    }
+    return true;
+}
 
+bool DataManager::load() {
     // 清空内存
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_users.clear();
     m_logs.clear();
+    m_idIndex.clear();
+    m_nameIndex.clear();
 
     string line;
-    while (getline(ifs, line)) {
-        if (line.empty()) continue;
-
-        if (m_type == TYPE_USER) {
-            // --- 读用户模式：需要解析 ---
-            stringstream ss(line);
-            int id;
-            string u, p, i;
-            // 格式：ID Name Password IP
-            // 确保能读到 4 个字段
-            if (ss >> id >> u >> p >> i) {
-                m_users.push_back(User(id, u, p, i));
-            }
-            if (id > m_maxId) {
-                m_maxId = id;
-            }
-        }
-        else if (m_type == TYPE_LOG) {
-            // --- 读日志模式：直接存 ---
-            m_logs.push_back(line);
+    if (m_type == TYPE_USER) {
+        // --- 读用户模式：快照 + 日志重放 ---
+        ifstream ifs(m_filename);
+        while (getline(ifs, line)) {
+            if (!line.empty()) parseUserLine(line);
         }
+        ifs.close();
+
+        if (m_journal.is_open()) m_journal.close();
+        size_t replayed = 0;
+        m_journalRecords = readJournalLines(m_journalName, [&](const string& record) {
+            if (parseUserLine(record)) replayed++;
+        });
+
+        // 打印加载信息
+        cout << ">> Loaded " << m_users.size() << " users (" << replayed << " from journal)." << endl;
+        return true;
     }
 
+    // --- 读日志模式：直接存 ---
+    ifstream ifs(m_filename);
+    if (!ifs.is_open()) return true; // 文件不存在
+    while (getline(ifs, line)) {
+        if (line.empty()) continue;
+        m_logs.push_back(line);
+    }
     ifs.close();
 
-    // 打印加载信息
-    if (m_type == TYPE_USER) cout << ">> Loaded " << m_users.size() << " users." << endl;
-    else cout << ">> Loaded " << m_logs.size() << " log entries." << endl;
-
+    cout << ">> Loaded " << m_logs.size() << " log entries." << endl;
     return true;
-}
\ No newline at end of file
+}
@@ -2,6 +2,9 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
 #include <fstream>
 #include <iostream>
 #include "User.h"
@@ -27,24 +30,56 @@ public:
     void setAutoSave(bool enable);
 
     // --- 用户专用操作 (TYPE_USER 时使用) ---
-    void addUser(const User& user);
+    // 【修改】用户名或 ID 已存在时返回 false (并发注册同名用户时只有一个成功)
+    bool addUser(const User& user);
+    // 全量拷贝，只适合低频场景；按 ID/用户名查找请用 findById / findByName
     vector<User> getAllUsers() const;
 
+    // 【新增】O(1) 索引查找，找不到返回 nullptr
+    // 用户只增不删且存放在 deque 中，返回的指针在 DataManager 生命周期内一直有效
+    const User* findById(int id) const;
+    const User* findByName(const string& name) const;
+    size_t getUserCount() const;
+
     // --- 日志专用操作 (TYPE_LOG 时使用) ---
     void addLog(string logInfo);
     // 这里可以加一个 getLogs() ...
 
     // --- 核心文件操作 ---
     // 这两个函数内部会自动判断 m_type
+    // 【修改】TYPE_USER 下 save() 即一次压缩：写出完整快照并清空日志
     bool save();
+    // 【修改】TYPE_USER 下先读快照，再重放 <filename>.journal 中追加的记录
     bool load();
 
+    // 【新增】本实例写入磁盘的总字节数 (快照 + 日志)，用于压测统计
+    unsigned long long getBytesWritten() const { return m_bytesWritten; }
+
 private:
+    bool saveLocked();
+    // 【新增】用户日志：注册只追加一行，累计到阈值后压缩进快照
+    bool appendJournalLocked(const User& user);
+    bool parseUserLine(const string& line);
+
+    // 日志条数超过 max(kCompactMin, 快照中的用户数) 时压缩，快照规模按倍数增长，
+    // 保证每次注册的摊还开销为 O(1)
+    static constexpr size_t kCompactMin = 4096;
+
     string m_filename;
     FileType m_type;       // 记住当前实例是管理哪种文件的
     bool m_autoSaveEnabled;
     int m_maxId = 1000;
     // 数据存储区
-    vector<User> m_users;  // 专门存用户
+    deque<User> m_users;   // 专门存用户 (deque 追加时不移动已有元素)
     vector<string> m_logs; // 专门存日志
-};
\ No newline at end of file
+
+    // 【新增】用户索引：值为 m_users 中的下标
+    unordered_map<int, size_t> m_idIndex;
+    unordered_map<string, size_t> m_nameIndex;
+
+    string m_journalName;               // m_filename + ".journal"
+    ofstream m_journal;                 // 常驻打开的追加句柄
+    size_t m_journalRecords = 0;        // 快照之后追加的记录数
+    unsigned long long m_bytesWritten = 0;
+    mutable std::mutex m_mutex; // 保护以上数据，各 I/O 线程会并发查询
+};
\ No newline at end of file
@@ -0,0 +1,135 @@
+﻿#include "FileHandleCache.h"
+#include <vector>
+#include <cerrno>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// ====================================================================
+// FileHandle
+// ====================================================================
+
+FileHandle::~FileHandle() {
+    if (m_syncOnClose && (m_buffered || m_unsynced)) sync();
+    fclose(m_file);
+}
+
+bool FileHandle::write(const void* data, size_t len) {
+    if (fwrite(data, 1, len, m_file) != len) return false;
+    m_buffered = true;
+    return true;
+}
+
+bool FileHandle::flush() {
+    if (!m_buffered) return true;
+    if (fflush(m_file) != 0) return false;
+    m_buffered = false;
+    m_unsynced = true;
+    return true;
+}
+
+bool FileHandle::sync() {
+    if (!flush()) return false;
+    if (!m_unsynced) return true;
+#ifdef _WIN32
+    if (_commit(_fileno(m_file)) != 0) return false;
+#else
+    if (fsync(fileno(m_file)) != 0) return false;
+#endif
+    m_unsynced = false;
+    return true;
+}
+
+// ====================================================================
+// FileHandleCache
+// ====================================================================
+
+FileHandleCache::FileHandleCache(size_t capacity)
+    : m_capacity(capacity > 0 ? capacity : 1)
+{
+}
+
+FileHandleCache::~FileHandleCache() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (!m_entries.empty()) dropLocked(m_entries.begin(), true);
+}
+
+FILE* FileHandleCache::openFile(const std::string& path, const char* mode) {
+    FILE* f = nullptr;
+    if (fopen_s(&f, path.c_str(), mode) != 0) return nullptr;
+    return f;
+}
+
+// 调用方需已持有 m_mutex；句柄若没有别人在用，就在锁内关闭
+void FileHandleCache::dropLocked(std::unordered_map<std::string, Entry>::iterator it, bool sync) {
+    it->second.handle->m_syncOnClose = sync;
+    m_lru.erase(it->second.lruPos);
+    m_entries.erase(it);
+}
+
+// 调用方需已持有 m_mutex
+void FileHandleCache::evictLocked(size_t count) {
+    while (count-- > 0 && !m_lru.empty()) {
+        dropLocked(m_entries.find(m_lru.back()), m_syncOnClose);
+        m_evictions++;
+    }
+}
+
+FileHandlePtr FileHandleCache::acquire(const std::string& path, const char* mode) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    auto it = m_entries.find(path);
+    if (it != m_entries.end()) {
+        m_hits++;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+        it->second.lastUsed = now;
+        return it->second.handle;
+    }
+
+    m_misses++;
+    if (m_entries.size() >= m_capacity) evictLocked(m_entries.size() - m_capacity + 1);
+    FILE* f = openFile(path, mode);
+    if (!f && (errno == EMFILE || errno == ENFILE) && !m_entries.empty()) {
+        // 进程句柄耗尽 (多半是别处也开了很多文件)：让出一半再试一次
+        evictLocked((m_entries.size() + 1) / 2);
+        f = openFile(path, mode);
+    }
+    if (!f) return nullptr;
+
+    m_lru.push_front(path);
+    Entry& e = m_entries[path];
+    e.handle.reset(new FileHandle(f, path));
+    e.lruPos = m_lru.begin();
+    e.lastUsed = now;
+    return e.handle;
+}
+
+FileHandlePtr FileHandleCache::find(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(path);
+    return it == m_entries.end() ? nullptr : it->second.handle;
+}
+
+void FileHandleCache::close(const std::string& path, bool sync) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(path);
+    if (it != m_entries.end()) dropLocked(it, sync);
+}
+
+void FileHandleCache::closeIdle(int idleSec) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto deadline = std::chrono::steady_clock::now() - std::chrono::seconds(idleSec);
+    // LRU 尾部最久未用，遇到第一个仍活跃的即可停止
+    while (!m_lru.empty()) {
+        auto it = m_entries.find(m_lru.back());
+        if (it->second.lastUsed > deadline) break;
+        dropLocked(it, m_syncOnClose);
+    }
+}
+
+size_t FileHandleCache::getOpenCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
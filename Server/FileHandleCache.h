@@ -0,0 +1,89 @@
+﻿#pragma once
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <unordered_map>
+
+// ====================================================================
+// FileHandleCache：按路径缓存打开的追加句柄，群聊、私聊记录和好友请求共用
+// 句柄数有上限，按 LRU 淘汰；长时间不用的句柄定期关闭；打开失败且是句柄耗尽时先淘汰一半再重试
+// 句柄只归缓存所有：调用方在自己的锁内取用，用完即放，不要长期保存
+// (同一路径的写入方必须互斥，淘汰在缓存锁内完成，保证旧句柄的缓冲先于新句柄写出)
+// ====================================================================
+
+class FileHandle {
+public:
+    ~FileHandle();
+
+    // 写入进缓冲；flush 交给操作系统，sync 再 fsync
+    bool write(const void* data, size_t len);
+    bool flush();
+    bool sync();
+
+    const std::string& path() const { return m_path; }
+
+private:
+    friend class FileHandleCache;
+    FileHandle(FILE* file, const std::string& path) : m_file(file), m_path(path) {}
+
+    FILE* m_file;
+    std::string m_path;
+    bool m_buffered = false;    // 缓冲里有尚未交给操作系统的数据
+    bool m_unsynced = false;    // 已交给操作系统但尚未 fsync
+    bool m_syncOnClose = false;
+};
+
+typedef std::shared_ptr<FileHandle> FileHandlePtr;
+
+class FileHandleCache {
+public:
+    explicit FileHandleCache(size_t capacity = kDefaultCapacity);
+    ~FileHandleCache();
+
+    // 取一个打开的句柄，不在缓存中时以 mode 打开；失败返回空
+    FileHandlePtr acquire(const std::string& path, const char* mode = "ab");
+    // 只查不开 (不计入命中率)
+    FileHandlePtr find(const std::string& path);
+
+    // 关闭一个路径的句柄 (改名/重写文件之前调用)
+    void close(const std::string& path, bool sync);
+    // 关闭超过 idleSec 秒没有取用的句柄
+    void closeIdle(int idleSec);
+
+    // 淘汰或空闲关闭时是否先 fsync 未同步的数据；由落盘模式决定
+    void setSyncOnClose(bool sync) { m_syncOnClose = sync; }
+
+    uint64_t getHits() const { return m_hits; }
+    uint64_t getMisses() const { return m_misses; }
+    uint64_t getEvictions() const { return m_evictions; }
+    size_t getOpenCount() const;
+    size_t getCapacity() const { return m_capacity; }
+
+    static constexpr size_t kDefaultCapacity = 256;    // MSVC 运行库默认最多 512 个 FILE*
+
+private:
+    struct Entry {
+        FileHandlePtr handle;
+        std::list<std::string>::iterator lruPos;
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    FILE* openFile(const std::string& path, const char* mode);
+    void dropLocked(std::unordered_map<std::string, Entry>::iterator it, bool sync);
+    void evictLocked(size_t count);
+
+    const size_t m_capacity;
+    std::atomic<bool> m_syncOnClose{ true };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::list<std::string> m_lru;   // 前面是最近使用的
+
+    std::atomic<uint64_t> m_hits{ 0 };
+    std::atomic<uint64_t> m_misses{ 0 };
+    std::atomic<uint64_t> m_evictions{ 0 };
+};
@@ -0,0 +1,111 @@
+﻿#include "FriendGraph.h"
+#include "JournalReader.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <cstdlib>
+
+namespace fs = std::filesystem;
+
+FriendGraph::FriendGraph(const std::string& fileName)
+    : m_fileName(fileName)
+{
+}
+
+bool FriendGraph::load(const std::string& recordDir) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_adjacency.clear();
+    m_edges = 0;
+    if (m_file.is_open()) m_file.close();
+
+    std::error_code ec;
+    if (!fs::exists(m_fileName, ec)) {
+        importLocked(recordDir);
+        std::cout << ">> Imported " << m_edges << " friendships from " << recordDir << "." << std::endl;
+        return true;
+    }
+
+    readJournalLines(m_fileName, [this](const std::string& line) {
+        size_t sep = line.find('|');
+        if (sep == std::string::npos) return;
+        int id1 = atoi(line.c_str());
+        int id2 = atoi(line.c_str() + sep + 1);
+        if (id1 > 0 && id2 > 0) insertLocked(id1, id2);
+    });
+    std::cout << ">> Loaded " << m_edges << " friendships." << std::endl;
+    return true;
+}
+
+// 调用方需已持有 m_mutex；旧版本的好友关系只体现在会话名上
+void FriendGraph::importLocked(const std::string& recordDir) {
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(recordDir, ec)) {
+        std::string name = entry.path().filename().string();
+        // 目录 "<小ID>_<大ID>"，或未转换的 "<小ID>_<大ID>.txt" / ".txt.imported"
+        size_t dot = name.find('.');
+        if (dot != std::string::npos) {
+            if (name.compare(dot, std::string::npos, ".txt") != 0 && name.compare(dot, std::string::npos, ".txt.imported") != 0) continue;
+            name.resize(dot);
+        }
+        size_t sep = name.find('_');
+        if (sep == std::string::npos) continue;
+        int id1 = atoi(name.c_str());
+        int id2 = atoi(name.c_str() + sep + 1);
+        if (id1 > 0 && id2 > 0 && id1 != id2 && insertLocked(id1, id2)) appendLocked(id1, id2);
+    }
+    // 没有任何好友时也建立文件，下次启动不再扫描
+    if (!m_file.is_open()) m_file.open(m_fileName, std::ios::out | std::ios::app | std::ios::binary);
+}
+
+// 调用方需已持有 m_mutex
+bool FriendGraph::insertLocked(int id1, int id2) {
+    std::vector<int>& a = m_adjacency[id1];
+    auto it = std::lower_bound(a.begin(), a.end(), id2);
+    if (it != a.end() && *it == id2) return false;
+    a.insert(it, id2);
+
+    std::vector<int>& b = m_adjacency[id2];
+    b.insert(std::lower_bound(b.begin(), b.end(), id1), id1);
+    m_edges++;
+    return true;
+}
+
+// 调用方需已持有 m_mutex
+bool FriendGraph::appendLocked(int id1, int id2) {
+    if (!m_file.is_open()) {
+        m_file.open(m_fileName, std::ios::out | std::ios::app | std::ios::binary);
+        if (!m_file.is_open()) return false;
+    }
+    m_file << std::min(id1, id2) << '|' << std::max(id1, id2) << '\n';
+    m_file.flush();
+    return m_file.good();
+}
+
+bool FriendGraph::addFriendship(int id1, int id2) {
+    if (id1 <= 0 || id2 <= 0 || id1 == id2) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!insertLocked(id1, id2)) return false;
+    if (!appendLocked(id1, id2)) {
+        std::cout << "[Error] Failed to persist friendship " << id1 << " <-> " << id2 << std::endl;
+    }
+    return true;
+}
+
+bool FriendGraph::areFriends(int id1, int id2) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_adjacency.find(id1);
+    if (it == m_adjacency.end()) return false;
+    return std::binary_search(it->second.begin(), it->second.end(), id2);
+}
+
+std::vector<int> FriendGraph::getFriends(int userId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_adjacency.find(userId);
+    if (it == m_adjacency.end()) return {};
+    return it->second;
+}
+
+size_t FriendGraph::getFriendshipCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_edges;
+}
@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <fstream>
+#include <unordered_map>
+
+// ====================================================================
+// FriendGraph：好友关系索引 (用户 ID -> 按 ID 排序的好友列表)
+// 持久化为 Friends.txt，每行一条关系 "小ID|大ID"，只追加；启动时整表载入
+// 文件不存在时从 FriendRecord 目录下的会话名 (<小ID>_<大ID> 及旧 .txt) 导入一次
+// 查询好友列表为 O(好友数)，不再扫描目录
+// ====================================================================
+
+class FriendGraph {
+public:
+    explicit FriendGraph(const std::string& fileName = "Friends.txt");
+
+    // recordDir：文件不存在时用于导入的会话目录
+    bool load(const std::string& recordDir = "FriendRecord");
+
+    // 已经是好友时返回 false
+    bool addFriendship(int id1, int id2);
+    bool areFriends(int id1, int id2) const;
+    std::vector<int> getFriends(int userId) const;
+    size_t getFriendshipCount() const;
+
+private:
+    bool insertLocked(int id1, int id2);
+    bool appendLocked(int id1, int id2);
+    void importLocked(const std::string& recordDir);
+
+    std::string m_fileName;
+    std::ofstream m_file;               // 常驻打开的追加句柄
+    std::unordered_map<int, std::vector<int>> m_adjacency;
+    size_t m_edges = 0;
+    mutable std::mutex m_mutex;
+};
@@ -1,25 +1,31 @@
 ﻿#include "Group.h"
+#include "JournalReader.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <ctime>
 #include <vector>
+#include <filesystem>
 
 // --- Group 实现 ---
 Group::Group(int id, string name, string time) : m_id(id), m_name(name), m_createTime(time) {}
 
 void Group::addMember(const string& username) {
-    if (!hasMember(username)) m_members.push_back(username);
+    if (m_memberSet.insert(username).second) {
+        m_members.push_back(username);
+        m_version++;
+    }
 }
 
 void Group::removeMember(const string& username) {
+    if (m_memberSet.erase(username) == 0) return;
+    m_version++;
     auto it = remove(m_members.begin(), m_members.end(), username);
     if (it != m_members.end()) m_members.erase(it, m_members.end());
 }
 
 bool Group::hasMember(const string& username) const {
-    for (const auto& m : m_members) if (m == username) return true;
-    return false;
+    return m_memberSet.count(username) > 0;
 }
 
 string Group::toString() const {
@@ -36,6 +42,7 @@ string Group::toString() const {
 
 void Group::parseMembers(const string& memberStr) {
     m_members.clear();
+    m_memberSet.clear();
     if (memberStr == "None") return;
     stringstream ss(memberStr);
     string seg;
@@ -46,18 +53,95 @@ void Group::parseMembers(const string& memberStr) {
             if (p != string::npos) {
                 cleanName = cleanName.substr(0, p);
             }
-            m_members.push_back(cleanName);
+            addMember(cleanName);
         }
     }
 }
 
 // --- GroupManager 实现 ---
-GroupManager::GroupManager() { load(); }
+GroupManager::GroupManager(const string& fileBasic, const string& filePerm)
+    : m_fileBasic(fileBasic), m_filePerm(filePerm), m_journalName(fileBasic + ".journal") { load(); }
 GroupManager::~GroupManager() { save(); }
 
+int GroupManager::roleLocked(const Shard& shard, int groupId, const string& username) {
+    auto roleIt = shard.roles.find(groupId);
+    if (roleIt != shard.roles.end()) {
+        auto it = roleIt->second.find(username);
+        if (it != roleIt->second.end()) return it->second;
+    }
+    return ROLE_MEMBER;
+}
+
+bool GroupManager::appendJournal(const string& record) {
+    lock_guard<mutex> lock(m_journalMutex);
+    if (!m_journal.is_open()) {
+        m_journal.open(m_journalName, ios::out | ios::app | ios::binary);
+    }
+    m_journal << record << '\n';
+    m_journal.flush();
+    if (!m_journal.good()) {
+        cout << "[Error] Failed to append group journal: " << record << endl;
+        m_journal.close();
+    }
+    m_journalRecords++;
+    return m_journalRecords > max(kCompactMin, m_snapshotRecords);
+}
+
+bool GroupManager::replayLocked(const vector<string>& parts) {
+    if (parts.size() < 3) return false;
+    int gid = atoi(parts[1].c_str());
+    if (gid <= 0) return false;
+    Shard& shard = shardFor(gid);
+
+    if (parts[0] == "C") {
+        if (parts.size() < 5 || shard.groups.count(gid)) return false;
+        Group g(gid, parts[2], parts[3]);
+        g.addMember(parts[4]);
+        shard.groups[gid] = g;
+        shard.roles[gid][parts[4]] = ROLE_OWNER;
+        m_nameIndex.emplace(parts[2], gid);
+        m_nameOrder.emplace(parts[2], gid);
+        m_userGroups[parts[4]].insert(gid);
+        if (gid > m_maxGroupId) m_maxGroupId = gid;
+        return true;
+    }
+
+    auto it = shard.groups.find(gid);
+    if (it == shard.groups.end()) return false;
+    const string& username = parts[2];
+    if (parts[0] == "J") {
+        it->second.addMember(username);
+        m_userGroups[username].insert(gid);
+    }
+    else if (parts[0] == "L") {
+        it->second.removeMember(username);
+        shard.roles[gid].erase(username);
+        auto userIt = m_userGroups.find(username);
+        if (userIt != m_userGroups.end()) {
+            userIt->second.erase(gid);
+            if (userIt->second.empty()) m_userGroups.erase(userIt);
+        }
+    }
+    else if (parts[0] == "R" && parts.size() >= 4) {
+        shard.roles[gid][username] = atoi(parts[3].c_str());
+        it->second.touch();
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
 void GroupManager::load() {
-    lock_guard<mutex> lock(m_mutex);
-    m_groups.clear(); m_groupRoles.clear(); m_maxGroupId = 0;
+    // 按固定顺序拿齐所有写锁
+    unique_lock<shared_mutex> nameLock(m_nameMutex);
+    vector<unique_lock<shared_mutex>> shardLocks;
+    for (Shard& shard : m_shards) shardLocks.emplace_back(shard.mutex);
+    unique_lock<shared_mutex> indexLock(m_indexMutex);
+    lock_guard<mutex> journalLock(m_journalMutex);
+
+    for (Shard& shard : m_shards) { shard.groups.clear(); shard.roles.clear(); }
+    m_nameIndex.clear(); m_nameOrder.clear(); m_userGroups.clear(); m_maxGroupId = 0;
 
     ifstream ifs1(m_fileBasic);
     string line;
@@ -67,6 +151,8 @@ void GroupManager::load() {
         int id; string name, time, mems;
         if (ss >> id >> name >> time >> mems) {
             Group g(id, name, time);
+            Shard& shard = shardFor(id);
+            map<string, int>& roles = shard.roles[id];
 
             if (mems != "None") {
                 stringstream mss(mems);
@@ -87,13 +173,16 @@ void GroupManager::load() {
                     }
 
                     g.addMember(uName);
+                    m_userGroups[uName].insert(id);
                     if (role != ROLE_MEMBER) {
-                        m_groupRoles[id][uName] = role;
+                        roles[uName] = role;
                     }
                 }
             }
 
-            m_groups[id] = g;
+            shard.groups[id] = g;
+            m_nameIndex.emplace(name, id);
+            m_nameOrder.emplace(name, id);
             if (id > m_maxGroupId) m_maxGroupId = id;
         }
     }
@@ -104,73 +193,134 @@ void GroupManager::load() {
         if (line.empty()) continue;
         stringstream ss(line);
         int gid, role; string u;
-        if (ss >> gid >> u >> role) m_groupRoles[gid][u] = role;
+        if (ss >> gid >> u >> role) {
+            Shard& shard = shardFor(gid);
+            auto it = shard.roles.find(gid);
+            if (it != shard.roles.end()) it->second[u] = role;
+        }
     }
     ifs2.close();
+
+    size_t groupCount = 0;
+    m_snapshotRecords = 0;
+    for (const Shard& shard : m_shards) {
+        groupCount += shard.groups.size();
+        for (const auto& pair : shard.groups) m_snapshotRecords += 1 + pair.second.getMemberCount();
+    }
+
+    // 【新增】重放快照之后的变更
+    if (m_journal.is_open()) m_journal.close();
+    size_t replayed = 0;
+    m_journalRecords = readJournalLines(m_journalName, [&](const string& record) {
+        vector<string> parts;
+        size_t begin = 0;
+        while (true) {
+            size_t sep = record.find('|', begin);
+            parts.push_back(record.substr(begin, sep == string::npos ? string::npos : sep - begin));
+            if (sep == string::npos) break;
+            begin = sep + 1;
+        }
+        if (replayLocked(parts)) replayed++;
+    });
+    cout << ">> Loaded " << groupCount << " groups from snapshot, replayed " << replayed << " of " << m_journalRecords << " journal records." << endl;
 }
 
 void GroupManager::save() {
-    lock_guard<mutex> lock(m_mutex);
-    ofstream ofs1(m_fileBasic, ios::trunc);
-
-    for (const auto& pair : m_groups) {
-        int gid = pair.first;
-        const Group& g = pair.second;
-        vector<string> members = g.getMembers();
-
-        string ownerStr = "";
-        string adminStr = "";
-        string memberStr = "";
-
-        for (const auto& m : members) {
-            int role = ROLE_MEMBER;
-            if (m_groupRoles.count(gid) && m_groupRoles[gid].count(m)) {
-                role = m_groupRoles[gid][m];
+    // 拿住所有分片的共享锁：快照期间变更暂停，快照与清空日志之间不会漏记录
+    vector<shared_lock<shared_mutex>> shardLocks;
+    for (Shard& shard : m_shards) shardLocks.emplace_back(shard.mutex);
+    lock_guard<mutex> journalLock(m_journalMutex);
+
+    // 逐个分片生成文本，最后按群 ID 排序写出，文件内容与分片前一致
+    vector<pair<int, string>> basicLines;
+    vector<pair<int, string>> permLines;
+    size_t snapshotRecords = 0;
+    for (const Shard& shard : m_shards) {
+        for (const auto& pair : shard.groups) {
+            int gid = pair.first;
+            const Group& g = pair.second;
+
+            string ownerStr = "";
+            string adminStr = "";
+            string memberStr = "";
+
+            for (const auto& m : g.getMembers()) {
+                int role = roleLocked(shard, gid, m);
+
+                if (role == ROLE_OWNER) {
+                    ownerStr = m + "(Owner)";
+                }
+                else if (role == ROLE_ADMIN) {
+                    if (!adminStr.empty()) adminStr += ",";
+                    adminStr += m + "(Admin)";
+                }
+                else {
+                    if (!memberStr.empty()) memberStr += ",";
+                    memberStr += m;
+                }
             }
 
-            if (role == ROLE_OWNER) {
-                ownerStr = m + "(Owner)";
-            }
-            else if (role == ROLE_ADMIN) {
-                if (!adminStr.empty()) adminStr += ",";
-                adminStr += m + "(Admin)";
+            string finalMems = ownerStr;
+            if (!adminStr.empty()) {
+                if (!finalMems.empty()) finalMems += ",";
+                finalMems += adminStr;
             }
-            else {
-                if (!memberStr.empty()) memberStr += ",";
-                memberStr += m;
+            if (!memberStr.empty()) {
+                if (!finalMems.empty()) finalMems += ",";
+                finalMems += memberStr;
             }
-        }
+            if (finalMems.empty()) finalMems = "None";
 
-        string finalMems = ownerStr;
-        if (!adminStr.empty()) {
-            if (!finalMems.empty()) finalMems += ",";
-            finalMems += adminStr;
+            basicLines.emplace_back(gid, to_string(g.getId()) + " " + g.getName() + " " + "2025-01-01" + " " + finalMems);
+            snapshotRecords += 1 + g.getMemberCount();
         }
-        if (!memberStr.empty()) {
-            if (!finalMems.empty()) finalMems += ",";
-            finalMems += memberStr;
+        for (const auto& gp : shard.roles) {
+            for (const auto& up : gp.second) {
+                if (up.second > ROLE_MEMBER)
+                    permLines.emplace_back(gp.first, to_string(gp.first) + " " + up.first + " " + to_string(up.second));
+            }
         }
-        if (finalMems.empty()) finalMems = "None";
-
-        ofs1 << g.getId() << " " << g.getName() << " " << "2025-01-01" << " " << finalMems << endl;
     }
-
-    ofstream ofs2(m_filePerm, ios::trunc);
-    for (const auto& gp : m_groupRoles) {
-        for (const auto& up : gp.second) {
-            if (up.second > ROLE_MEMBER)
-                ofs2 << gp.first << " " << up.first << " " << up.second << endl;
+    // 同一群的多行权限保持原有的用户名顺序
+    auto byGroup = [](const pair<int, string>& a, const pair<int, string>& b) { return a.first < b.first; };
+    sort(basicLines.begin(), basicLines.end(), byGroup);
+    stable_sort(permLines.begin(), permLines.end(), byGroup);
+
+    // 【修改】先写临时文件再替换，中途崩溃时旧快照 + 日志仍然完整 (日志重放是幂等的)
+    string tmpBasic = m_fileBasic + ".tmp";
+    string tmpPerm = m_filePerm + ".tmp";
+    {
+        ofstream ofs1(tmpBasic, ios::trunc);
+        for (const auto& l : basicLines) ofs1 << l.second << '\n';
+        ofstream ofs2(tmpPerm, ios::trunc);
+        for (const auto& l : permLines) ofs2 << l.second << '\n';
+        ofs1.close();
+        ofs2.close();
+        if (ofs1.fail() || ofs2.fail()) {
+            cout << "[Error] Failed to write group snapshot." << endl;
+            return;
         }
     }
+    std::error_code ec;
+    filesystem::rename(tmpBasic, m_fileBasic, ec);
+    if (!ec) filesystem::rename(tmpPerm, m_filePerm, ec);
+    if (ec) {
+        cout << "[Error] Failed to replace group snapshot: " << ec.message() << endl;
+        return;
+    }
+
+    // 快照已包含全部变更，日志可以清空
+    if (m_journal.is_open()) m_journal.close();
+    m_journal.open(m_journalName, ios::out | ios::trunc | ios::binary);
+    m_journalRecords = 0;
+    m_snapshotRecords = snapshotRecords;
 }
 
 int GroupManager::createGroup(string groupName, string ownerName) {
-    lock_guard<mutex> lock(m_mutex);
-
-    for (const auto& pair : m_groups) {
-        if (pair.second.getName() == groupName) {
-            return -1;
-        }
+    // 持有群名写锁直到建完，防止同名并发建群
+    unique_lock<shared_mutex> nameLock(m_nameMutex);
+    if (m_nameIndex.count(groupName)) {
+        return -1;
     }
 
     int newId = ++m_maxGroupId;
@@ -180,96 +330,227 @@ int GroupManager::createGroup(string groupName, string ownerName) {
 
     Group g(newId, groupName, string(buf));
     g.addMember(ownerName);
-    m_groups[newId] = g;
-    m_groupRoles[newId][ownerName] = ROLE_OWNER;
+    bool compactDue = false;
+    {
+        Shard& shard = shardFor(newId);
+        unique_lock<shared_mutex> lock(shard.mutex);
+        shard.groups[newId] = g;
+        shard.roles[newId][ownerName] = ROLE_OWNER;
+        compactDue = appendJournal("C|" + to_string(newId) + "|" + groupName + "|" + string(buf) + "|" + ownerName);
+    }
+    {
+        unique_lock<shared_mutex> indexLock(m_indexMutex);
+        m_userGroups[ownerName].insert(newId);
+    }
+    m_nameIndex[groupName] = newId;
+    m_nameOrder[groupName] = newId;
+    nameLock.unlock();
+    compactIfDue(compactDue);
     return newId;
 }
 
 bool GroupManager::joinGroup(int groupId, string username) {
-    lock_guard<mutex> lock(m_mutex);
-    if (m_groups.find(groupId) == m_groups.end()) return false;
-    if (m_groups[groupId].getMembers().size() >= 100) return false;
-    m_groups[groupId].addMember(username);
+    bool compactDue = false;
+    {
+        Shard& shard = shardFor(groupId);
+        unique_lock<shared_mutex> lock(shard.mutex);
+        auto it = shard.groups.find(groupId);
+        if (it == shard.groups.end()) return false;
+        if (it->second.getMemberCount() >= 100) return false;
+        // 已在群里时不重复记日志
+        if (it->second.hasMember(username)) return true;
+        it->second.addMember(username);
+        compactDue = appendJournal("J|" + to_string(groupId) + "|" + username);
+
+        unique_lock<shared_mutex> indexLock(m_indexMutex);
+        m_userGroups[username].insert(groupId);
+    }
+    compactIfDue(compactDue);
     return true;
 }
 
 bool GroupManager::leaveGroup(int groupId, string username) {
-    lock_guard<mutex> lock(m_mutex);
-    if (m_groups.find(groupId) == m_groups.end()) return false;
-    m_groups[groupId].removeMember(username);
-    if (m_groupRoles[groupId].count(username)) m_groupRoles[groupId].erase(username);
+    bool compactDue = false;
+    {
+        Shard& shard = shardFor(groupId);
+        unique_lock<shared_mutex> lock(shard.mutex);
+        auto it = shard.groups.find(groupId);
+        if (it == shard.groups.end()) return false;
+        bool wasMember = it->second.hasMember(username);
+        it->second.removeMember(username);
+        bool hadRole = shard.roles[groupId].erase(username) > 0;
+        if (!wasMember && !hadRole) return true;
+        if (!wasMember) it->second.touch();
+        compactDue = appendJournal("L|" + to_string(groupId) + "|" + username);
+
+        unique_lock<shared_mutex> indexLock(m_indexMutex);
+        auto userIt = m_userGroups.find(username);
+        if (userIt != m_userGroups.end()) {
+            userIt->second.erase(groupId);
+            if (userIt->second.empty()) m_userGroups.erase(userIt);
+        }
+    }
+    compactIfDue(compactDue);
     return true;
 }
 
+// 【修改】群不存在时忽略，不再为不存在的群登记权限
 void GroupManager::setUserRole(int groupId, string username, GroupRole role) {
-    lock_guard<mutex> lock(m_mutex);
-    m_groupRoles[groupId][username] = (int)role;
+    bool compactDue = false;
+    {
+        Shard& shard = shardFor(groupId);
+        unique_lock<shared_mutex> lock(shard.mutex);
+        auto it = shard.groups.find(groupId);
+        if (it == shard.groups.end()) return;
+        shard.roles[groupId][username] = (int)role;
+        it->second.touch();
+        compactDue = appendJournal("R|" + to_string(groupId) + "|" + username + "|" + to_string((int)role));
+    }
+    compactIfDue(compactDue);
 }
 
 bool GroupManager::checkPermission(int groupId, string username, GroupRole requiredRole) {
-    lock_guard<mutex> lock(m_mutex);
-    if (m_groups.find(groupId) == m_groups.end()) return false;
-    if (!m_groups[groupId].hasMember(username)) return false;
+    Shard& shard = shardFor(groupId);
+    shared_lock<shared_mutex> lock(shard.mutex);
+    auto it = shard.groups.find(groupId);
+    if (it == shard.groups.end()) return false;
+    if (!it->second.hasMember(username)) return false;
 
-    int currentLevel = ROLE_MEMBER;
-    if (m_groupRoles.count(groupId) && m_groupRoles[groupId].count(username)) {
-        currentLevel = m_groupRoles[groupId][username];
-    }
-    return currentLevel >= (int)requiredRole;
+    return roleLocked(shard, groupId, username) >= (int)requiredRole;
 }
 
 // 【新增】获取具体权限等级
 int GroupManager::getUserRole(int groupId, string username) {
-    lock_guard<mutex> lock(m_mutex);
-    if (m_groups.find(groupId) == m_groups.end()) return 0;
+    Shard& shard = shardFor(groupId);
+    shared_lock<shared_mutex> lock(shard.mutex);
+    if (shard.groups.find(groupId) == shard.groups.end()) return 0;
 
-    int currentLevel = ROLE_MEMBER; // 默认为成员 (1)
-    if (m_groupRoles.count(groupId) && m_groupRoles[groupId].count(username)) {
-        currentLevel = m_groupRoles[groupId][username];
-    }
-    return currentLevel;
+    return roleLocked(shard, groupId, username); // 默认为成员 (1)
 }
 
 string GroupManager::getGroupName(int groupId) {
-    lock_guard<mutex> lock(m_mutex);
-    if (m_groups.count(groupId)) return m_groups[groupId].getName();
+    Shard& shard = shardFor(groupId);
+    shared_lock<shared_mutex> lock(shard.mutex);
+    auto it = shard.groups.find(groupId);
+    if (it != shard.groups.end()) return it->second.getName();
     return "Unknown";
 }
 
 int GroupManager::getGroupIdByName(string name) {
-    lock_guard<mutex> lock(m_mutex);
-    for (const auto& pair : m_groups) {
-        if (pair.second.getName() == name) {
-            return pair.first;
-        }
-    }
-    return -1;
+    shared_lock<shared_mutex> lock(m_nameMutex);
+    auto it = m_nameIndex.find(name);
+    return it == m_nameIndex.end() ? -1 : it->second;
 }
 
 vector<string> GroupManager::getGroupMembers(int groupId) {
-    lock_guard<mutex> lock(m_mutex);
-    if (m_groups.find(groupId) != m_groups.end()) {
-        return m_groups[groupId].getMembers();
+    Shard& shard = shardFor(groupId);
+    shared_lock<shared_mutex> lock(shard.mutex);
+    auto it = shard.groups.find(groupId);
+    if (it != shard.groups.end()) {
+        return it->second.getMembers();
     }
     return vector<string>();
 }
 
+bool GroupManager::getRoster(int groupId, vector<RosterEntry>& out, uint64_t& version) {
+    Shard& shard = shardFor(groupId);
+    shared_lock<shared_mutex> lock(shard.mutex);
+    auto it = shard.groups.find(groupId);
+    if (it == shard.groups.end()) return false;
+    out.clear();
+    out.reserve(it->second.getMemberCount());
+    for (const auto& m : it->second.members()) out.push_back({ m, roleLocked(shard, groupId, m) });
+    version = it->second.getVersion();
+    return true;
+}
+
+bool GroupManager::getGroupVersion(int groupId, uint64_t& version) {
+    Shard& shard = shardFor(groupId);
+    shared_lock<shared_mutex> lock(shard.mutex);
+    auto it = shard.groups.find(groupId);
+    if (it == shard.groups.end()) return false;
+    version = it->second.getVersion();
+    return true;
+}
+
+vector<int> GroupManager::getUserGroups(const string& username) {
+    shared_lock<shared_mutex> lock(m_indexMutex);
+    auto it = m_userGroups.find(username);
+    if (it == m_userGroups.end()) return {};
+    return vector<int>(it->second.begin(), it->second.end());
+}
+
+bool GroupManager::isMember(int groupId, const string& username) {
+    Shard& shard = shardFor(groupId);
+    shared_lock<shared_mutex> lock(shard.mutex);
+    auto it = shard.groups.find(groupId);
+    return it != shard.groups.end() && it->second.hasMember(username);
+}
+
+// 【新增】只看权限表里登记过的人，普通成员不在其中
+vector<string> GroupManager::getGroupManagers(int groupId) {
+    Shard& shard = shardFor(groupId);
+    shared_lock<shared_mutex> lock(shard.mutex);
+    vector<string> managers;
+    auto groupIt = shard.groups.find(groupId);
+    auto roleIt = shard.roles.find(groupId);
+    if (groupIt == shard.groups.end() || roleIt == shard.roles.end()) return managers;
+    for (const auto& pair : roleIt->second) {
+        if (pair.second >= ROLE_ADMIN && groupIt->second.hasMember(pair.first)) managers.push_back(pair.first);
+    }
+    return managers;
+}
+
 string GroupManager::getGroupListCmd() {
+    vector<pair<int, string>> groups;
+    for (Shard& shard : m_shards) {
+        shared_lock<shared_mutex> lock(shard.mutex);
+        for (const auto& pair : shard.groups) groups.emplace_back(pair.first, pair.second.getName());
+    }
+    sort(groups.begin(), groups.end());
+
     string cmd = "CMD:GROUP_LIST|";
-    lock_guard<mutex> lock(m_mutex);
-    for (const auto& pair : m_groups) {
-        cmd += to_string(pair.first) + "," + pair.second.getName() + ";";
+    for (const auto& g : groups) {
+        cmd += to_string(g.first) + "," + g.second + ";";
     }
     return cmd;
 }
 
 string GroupManager::getMyGroupListCmd(string username) {
     string cmd = "CMD:GROUP_LIST|";
-    lock_guard<mutex> lock(m_mutex);
-    for (const auto& pair : m_groups) {
-        if (pair.second.hasMember(username)) {
-            cmd += to_string(pair.first) + "," + pair.second.getName() + ";";
-        }
+    // 【修改】走反向索引，不再遍历全部群；先拷出群 ID 再逐个查群名，不同时持有两把锁
+    set<int> gids;
+    {
+        shared_lock<shared_mutex> indexLock(m_indexMutex);
+        auto userIt = m_userGroups.find(username);
+        if (userIt == m_userGroups.end()) return cmd;
+        gids = userIt->second;
+    }
+    for (int gid : gids) {
+        Shard& shard = shardFor(gid);
+        shared_lock<shared_mutex> lock(shard.mutex);
+        auto it = shard.groups.find(gid);
+        if (it != shard.groups.end()) cmd += to_string(gid) + "," + it->second.getName() + ";";
+    }
+    return cmd;
+}
+
+// 【新增】群名按字节序排序，UTF-8 下字节前缀即字符前缀
+vector<pair<int, string>> GroupManager::searchGroups(const string& prefix, size_t limit) {
+    vector<pair<int, string>> result;
+    if (limit > kSearchLimitMax) limit = kSearchLimitMax;
+    shared_lock<shared_mutex> lock(m_nameMutex);
+    for (auto it = m_nameOrder.lower_bound(prefix); it != m_nameOrder.end() && result.size() < limit; ++it) {
+        if (it->first.compare(0, prefix.size(), prefix) != 0) break;
+        result.emplace_back(it->second, it->first);
+    }
+    return result;
+}
+
+string GroupManager::getGroupSearchCmd(const string& prefix, size_t limit) {
+    string cmd = "CMD:GROUP_SEARCH|" + prefix + "|";
+    for (const auto& g : searchGroups(prefix, limit)) {
+        cmd += to_string(g.first) + "," + g.second + ";";
     }
     return cmd;
-}
\ No newline at end of file
+}
\ No newline at end of file
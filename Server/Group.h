@@ -2,7 +2,14 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
 #include <iostream>
 
 using namespace std;
@@ -22,6 +29,11 @@ public:
     int getId() const { return m_id; }
     string getName() const { return m_name; }
     vector<string> getMembers() const { return m_members; }
+    const vector<string>& members() const { return m_members; }
+    size_t getMemberCount() const { return m_members.size(); }
+    // 【新增】成员或权限每变一次加一，用于判断缓存的成员列表是否过期
+    uint64_t getVersion() const { return m_version; }
+    void touch() { m_version++; }
 
     void addMember(const string& username);
     void removeMember(const string& username);
@@ -33,15 +45,33 @@ private:
     int m_id;
     string m_name;
     string m_createTime;
-    vector<string> m_members;
+    vector<string> m_members;               // 保持加入顺序，用于存盘和成员列表
+    unordered_set<string> m_memberSet;      // 【新增】成员判重/查询 O(1)
+    uint64_t m_version = 0;
 };
 
+// ====================================================================
+// GroupManager：群组与群内权限
+// 【修改】按群 ID 分片加读写锁：每个分片持有 ID % kShardCount 相同的群及其权限表，
+// 读操作只对所在分片加共享锁，不同群上的并发读写互不阻塞；
+// 群名索引、成员反向索引各有独立的读写锁。
+// 加锁顺序固定为 群名索引 -> 分片 (按下标递增) -> 反向索引/日志，避免死锁。
+// 【新增】持久化：Group1.txt/Group2.txt 为快照，每次变更只向 Group1.txt.journal 追加一行
+//   C|群ID|群名|创建时间|群主      建群
+//   J|群ID|用户名                 入群
+//   L|群ID|用户名                 退群/被踢
+//   R|群ID|用户名|权限            设置权限
+// 记录在分片写锁内追加，同一群的记录顺序与内存中的变更顺序一致；重放是幂等的。
+// 日志条数超过 max(kCompactMin, 快照规模) 时 save() 写出新快照并清空日志。
+// ====================================================================
+
 class GroupManager {
 public:
-    GroupManager();
+    GroupManager(const string& fileBasic = "Group1.txt", const string& filePerm = "Group2.txt");
     ~GroupManager();
 
     void load();
+    // 【修改】写出完整快照并清空日志；变更已经实时记入日志，只需在退出时或日志过长时调用
     void save();
 
     // 业务操作
@@ -60,6 +90,19 @@ public:
 
     // 获取群成员
     vector<string> getGroupMembers(int groupId);
+    // 【新增】成员及其权限的一致快照 (一次加锁)，version 为对应的群版本；群不存在时返回 false
+    struct RosterEntry {
+        string name;
+        int role;
+    };
+    bool getRoster(int groupId, vector<RosterEntry>& out, uint64_t& version);
+    bool getGroupVersion(int groupId, uint64_t& version);
+    // 【新增】用户所在的群 (反向索引)
+    vector<int> getUserGroups(const string& username);
+    // 【新增】只判断是否在群内，不复制成员列表
+    bool isMember(int groupId, const string& username);
+    // 【新增】群主和管理员 (能处理入群申请的人)
+    vector<string> getGroupManagers(int groupId);
 
     // 获取群组列表协议字符串 (CMD:GROUP_LIST|...)
     string getGroupListCmd();
@@ -67,12 +110,54 @@ public:
     // 获取“我”加入的群组列表
     string getMyGroupListCmd(string username);
 
+    // 【新增】按群名前缀查找，按群名排序，最多 limit 个
+    vector<pair<int, string>> searchGroups(const string& prefix, size_t limit);
+    // CMD:GROUP_SEARCH|前缀|ID,群名;ID,群名;...  回带前缀，客户端据此丢弃过期的结果
+    string getGroupSearchCmd(const string& prefix, size_t limit);
+
+    static constexpr size_t kShardCount = 64;
+    static constexpr size_t kCompactMin = 4096;
+    static constexpr size_t kSearchLimitMax = 50;
+
 private:
-    string m_fileBasic = "Group1.txt";
-    string m_filePerm = "Group2.txt";
-
-    map<int, Group> m_groups;
-    map<int, map<string, int>> m_groupRoles;
-    mutex m_mutex;
-    int m_maxGroupId = 0;
-};
\ No newline at end of file
+    struct Shard {
+        mutable shared_mutex mutex;
+        map<int, Group> groups;
+        map<int, map<string, int>> roles;   // 只登记群主/管理员，键为已存在的群
+    };
+
+    Shard& shardFor(int groupId) { return m_shards[(unsigned)groupId % kShardCount]; }
+    // 调用方需已持有分片锁
+    static int roleLocked(const Shard& shard, int groupId, const string& username);
+
+    // 【新增】追加一条日志，调用方需已持有该群所在分片的写锁；返回是否该压缩了
+    bool appendJournal(const string& record);
+    // 调用方需已释放所有锁
+    void compactIfDue(bool due) { if (due) save(); }
+    // load 时重放一条日志，调用方需已持有全部写锁
+    bool replayLocked(const vector<string>& parts);
+
+    string m_fileBasic;
+    string m_filePerm;
+
+    Shard m_shards[kShardCount];
+
+    // 群名 -> 群 ID，建群判重和按名查找都是 O(1)
+    unordered_map<string, int> m_nameIndex;
+    // 【新增】按群名排序的同一份索引，前缀查找为 O(log 群数 + 结果数)
+    map<string, int> m_nameOrder;
+    shared_mutex m_nameMutex;
+
+    // 【新增】反向索引：用户名 -> 所在群 ID (有序，列表顺序与按群 ID 遍历一致)
+    // 随 load/createGroup/joinGroup/leaveGroup 同步维护，查"我的群"只看自己所在的群
+    unordered_map<string, set<int>> m_userGroups;
+    shared_mutex m_indexMutex;
+
+    atomic<int> m_maxGroupId{ 0 };
+
+    string m_journalName;               // m_fileBasic + ".journal"
+    ofstream m_journal;                 // 常驻打开的追加句柄
+    size_t m_journalRecords = 0;        // 快照之后追加的记录数
+    size_t m_snapshotRecords = 0;       // 快照规模 (群数 + 成员数)
+    mutex m_journalMutex;               // 保护以上日志状态，并串行化写快照
+};
\ No newline at end of file
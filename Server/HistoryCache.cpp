@@ -0,0 +1,140 @@
+﻿#include "HistoryCache.h"
+#include "HistoryStore.h"
+#include <algorithm>
+
+HistoryCache::HistoryCache(size_t budgetBytes, size_t ringSize)
+    : m_budget(budgetBytes)
+    , m_ringSize(ringSize)
+{
+}
+
+size_t HistoryCache::recordBytes(const HistoryRecord& rec) {
+    return sizeof(HistoryRecord) + rec.senderName.capacity() + rec.content.capacity() + rec.time.capacity()
+        + rec.hiddenFor.capacity() * sizeof(int);
+}
+
+bool HistoryCache::contains(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.count(key) > 0;
+}
+
+// 调用方需已持有 m_mutex；不存在时新建
+HistoryCache::Entry& HistoryCache::touchLocked(const std::string& key) {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        m_lru.push_front(key);
+        Entry& e = m_entries[key];
+        e.lruPos = m_lru.begin();
+        return e;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+    return it->second;
+}
+
+// 调用方需已持有 m_mutex；从最久未用的会话开始淘汰，刚访问的 keep 不动
+void HistoryCache::evictLocked(const std::string& keep) {
+    while (m_bytes > m_budget && !m_lru.empty() && m_lru.back() != keep) {
+        auto it = m_entries.find(m_lru.back());
+        m_bytes -= it->second.bytes;
+        m_entries.erase(it);
+        m_lru.pop_back();
+    }
+}
+
+void HistoryCache::append(const std::string& key, const HistoryRecord& rec) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // 不在缓存中的会话等第一次读取时再整体装入，否则环里只有新消息，读最新一页反而总是未命中
+    if (rec.seq != 0 && m_entries.count(key) == 0) return;
+    Entry& e = touchLocked(key);
+    if (rec.seq == 0) e.complete = true;
+
+    e.ring.push_back(rec);
+    size_t b = recordBytes(rec);
+    e.bytes += b;
+    m_bytes += b;
+    while (e.ring.size() > m_ringSize) {
+        b = recordBytes(e.ring.front());
+        e.bytes -= b;
+        m_bytes -= b;
+        e.ring.pop_front();
+        e.complete = false;
+    }
+    evictLocked(key);
+}
+
+void HistoryCache::fill(const std::string& key, const std::vector<HistoryRecord>& latest) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry& e = touchLocked(key);
+    m_bytes -= e.bytes;
+    e.ring.clear();
+    e.bytes = 0;
+
+    size_t start = latest.size() > m_ringSize ? latest.size() - m_ringSize : 0;
+    for (size_t i = start; i < latest.size(); ++i) {
+        e.ring.push_back(latest[i]);
+        e.bytes += recordBytes(latest[i]);
+    }
+    e.complete = e.ring.empty() || e.ring.front().seq == 0;
+    m_bytes += e.bytes;
+    evictLocked(key);
+}
+
+void HistoryCache::hide(const std::string& key, MessageId id, int userId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) return;
+    std::deque<HistoryRecord>& ring = it->second.ring;
+    auto rit = std::lower_bound(ring.begin(), ring.end(), id,
+        [](const HistoryRecord& r, MessageId v) { return r.id < v; });
+    if (rit != ring.end() && rit->id == id && !rit->isHiddenFor(userId)) rit->hiddenFor.push_back(userId);
+}
+
+bool HistoryCache::readBefore(const std::string& key, MessageId beforeId, size_t limit, int viewerId,
+    std::vector<HistoryRecord>& out, MessageId& nextCursor, bool countStats) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        if (countStats) m_misses++;
+        return false;
+    }
+    Entry& e = it->second;
+    const std::deque<HistoryRecord>& ring = e.ring;
+
+    size_t end = ring.size();
+    if (beforeId != 0) {
+        end = (size_t)(std::lower_bound(ring.begin(), ring.end(), beforeId,
+            [](const HistoryRecord& r, MessageId v) { return r.id < v; }) - ring.begin());
+    }
+
+    // 从 end 往前收集可见记录；走到环头还不够且更早处还有记录时算未命中
+    std::vector<const HistoryRecord*> picked;
+    size_t i = end;
+    while (i > 0 && picked.size() < limit) {
+        --i;
+        if (viewerId == 0 || !ring[i].isHiddenFor(viewerId)) picked.push_back(&ring[i]);
+    }
+    if (picked.size() < limit && !e.complete) {
+        if (countStats) m_misses++;
+        return false;
+    }
+
+    out.clear();
+    out.reserve(picked.size());
+    for (auto p = picked.rbegin(); p != picked.rend(); ++p) out.push_back(**p);
+    // 游标是最早检查过的那条；不够 limit 说明已经读到会话开头
+    nextCursor = (picked.size() < limit || i >= ring.size() || ring[i].seq == 0) ? 0 : ring[i].id;
+
+    m_lru.splice(m_lru.begin(), m_lru, e.lruPos);
+    if (countStats) m_hits++;
+    return true;
+}
+
+size_t HistoryCache::getBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+size_t HistoryCache::getConversationCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+#include <list>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "MessageId.h"
+
+struct HistoryRecord;
+
+// ====================================================================
+// HistoryCache：每个会话最近若干条消息的内存环
+// 写入时追加，第一次读取时从存储装入；总内存超出预算时按 LRU 整个淘汰冷会话
+// 最新一页 (以及环内能覆盖的翻页) 不再访问磁盘
+// ====================================================================
+
+class HistoryCache {
+public:
+    explicit HistoryCache(size_t budgetBytes = 32 * 1024 * 1024, size_t ringSize = 512);
+
+    bool contains(const std::string& key) const;
+
+    // 新消息；只追加到已缓存的会话 (新会话的第一条除外)
+    void append(const std::string& key, const HistoryRecord& rec);
+    // 用存储中最新的若干条 (按序号升序) 装入/替换一个会话
+    void fill(const std::string& key, const std::vector<HistoryRecord>& latest);
+    void hide(const std::string& key, MessageId id, int userId);
+
+    // 语义同 HistoryStore::readBefore；环里覆盖不到时返回 false，由调用方回退到存储
+    // countStats 为 false 时不计入命中率 (装入后立即重试的那一次)
+    bool readBefore(const std::string& key, MessageId beforeId, size_t limit, int viewerId,
+        std::vector<HistoryRecord>& out, MessageId& nextCursor, bool countStats = true);
+
+    uint64_t getHits() const { return m_hits; }
+    uint64_t getMisses() const { return m_misses; }
+    size_t getBytes() const;
+    size_t getConversationCount() const;
+    size_t getRingSize() const { return m_ringSize; }
+
+private:
+    struct Entry {
+        std::deque<HistoryRecord> ring;
+        bool complete = false;      // 环从序号 0 开始，之前没有更早的记录
+        size_t bytes = 0;
+        std::list<std::string>::iterator lruPos;
+    };
+
+    static size_t recordBytes(const HistoryRecord& rec);
+    Entry& touchLocked(const std::string& key);
+    void evictLocked(const std::string& keep);
+
+    const size_t m_budget;
+    const size_t m_ringSize;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::list<std::string> m_lru;   // 前面是最近使用的
+    size_t m_bytes = 0;
+
+    std::atomic<uint64_t> m_hits{ 0 };
+    std::atomic<uint64_t> m_misses{ 0 };
+};
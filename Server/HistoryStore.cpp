@@ -0,0 +1,855 @@
+﻿#include "HistoryStore.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include <filesystem>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const uint32_t kRecordMagic = 0x51514557;   // "WEQQ"
+const uint32_t kHiddenMagic = 0x44444948;   // "HIDD"
+const char* kManifestHeader = "WEQQ-HISTORY 1";
+
+#pragma pack(push, 1)
+struct Tombstone {
+    uint64_t seq;
+    uint64_t id;
+    int32_t userId;
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t length;        // 含头部的整条记录长度
+    uint64_t id;
+    uint64_t seq;
+    int32_t senderId;
+    uint16_t nameLen;
+    uint16_t timeLen;
+    uint32_t contentLen;
+    uint32_t hiddenCount;
+};
+#pragma pack(pop)
+
+void encodeRecord(const HistoryRecord& rec, std::string& out) {
+    RecordHeader h = {};
+    h.magic = kRecordMagic;
+    h.id = rec.id;
+    h.seq = rec.seq;
+    h.senderId = rec.senderId;
+    h.nameLen = (uint16_t)std::min<size_t>(rec.senderName.size(), 0xFFFF);
+    h.timeLen = (uint16_t)std::min<size_t>(rec.time.size(), 0xFFFF);
+    h.contentLen = (uint32_t)rec.content.size();
+    h.hiddenCount = (uint32_t)rec.hiddenFor.size();
+    h.length = (uint32_t)(sizeof(h) + h.nameLen + h.timeLen + h.contentLen + h.hiddenCount * sizeof(int32_t));
+
+    size_t start = out.size();
+    out.resize(start + h.length);
+    char* p = &out[start];
+    memcpy(p, &h, sizeof(h));                       p += sizeof(h);
+    memcpy(p, rec.senderName.data(), h.nameLen);    p += h.nameLen;
+    memcpy(p, rec.time.data(), h.timeLen);          p += h.timeLen;
+    memcpy(p, rec.content.data(), h.contentLen);    p += h.contentLen;
+    for (int uid : rec.hiddenFor) {
+        int32_t v = uid;
+        memcpy(p, &v, sizeof(v));
+        p += sizeof(v);
+    }
+}
+
+bool readHeader(std::istream& in, RecordHeader& h) {
+    if (!in.read((char*)&h, sizeof(h))) return false;
+    if (h.magic != kRecordMagic) return false;
+    uint64_t expect = (uint64_t)sizeof(h) + h.nameLen + h.timeLen + h.contentLen + (uint64_t)h.hiddenCount * sizeof(int32_t);
+    return expect == h.length;
+}
+
+bool readBody(std::istream& in, const RecordHeader& h, HistoryRecord& rec) {
+    rec.id = h.id;
+    rec.seq = h.seq;
+    rec.senderId = h.senderId;
+    rec.senderName.resize(h.nameLen);
+    rec.time.resize(h.timeLen);
+    rec.content.resize(h.contentLen);
+    rec.hiddenFor.resize(h.hiddenCount);
+    if (h.nameLen && !in.read(&rec.senderName[0], h.nameLen)) return false;
+    if (h.timeLen && !in.read(&rec.time[0], h.timeLen)) return false;
+    if (h.contentLen && !in.read(&rec.content[0], h.contentLen)) return false;
+    for (uint32_t i = 0; i < h.hiddenCount; ++i) {
+        int32_t v = 0;
+        if (!in.read((char*)&v, sizeof(v))) return false;
+        rec.hiddenFor[i] = v;
+    }
+    return true;
+}
+
+void skipBody(std::istream& in, const RecordHeader& h) {
+    in.seekg(h.length - sizeof(h), std::ios::cur);
+}
+
+// 旧格式的删除标记："d<用户ID>," 重复若干次
+std::vector<int> parseLegacyDeletes(const std::string& field) {
+    std::vector<int> users;
+    size_t pos = 0;
+    while ((pos = field.find('d', pos)) != std::string::npos) {
+        int uid = atoi(field.c_str() + pos + 1);
+        if (uid != 0 && std::find(users.begin(), users.end(), uid) == users.end()) users.push_back(uid);
+        ++pos;
+    }
+    return users;
+}
+
+}
+
+bool HistoryRecord::isHiddenFor(int userId) const {
+    return std::find(hiddenFor.begin(), hiddenFor.end(), userId) != hiddenFor.end();
+}
+
+HistoryStore::HistoryStore(FileHandleCache& files)
+    : m_files(files)
+{
+}
+
+HistoryStore::~HistoryStore() {
+    stop();
+    flush(true);
+}
+
+void HistoryStore::start() {
+    if (m_running) return;
+    m_running = true;
+    m_thread = std::thread(&HistoryStore::compactLoop, this);
+}
+
+// 退出前把积压的删除都并入段文件
+void HistoryStore::stop() {
+    if (!m_running.exchange(false)) return;
+    m_wakeCv.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+std::string HistoryStore::groupKey(const std::string& groupName) {
+    return "GroupRecord/" + groupName;
+}
+
+std::string HistoryStore::friendKey(int id1, int id2) {
+    int minId = (id1 < id2) ? id1 : id2;
+    int maxId = (id1 > id2) ? id1 : id2;
+    return "FriendRecord/" + std::to_string(minId) + "_" + std::to_string(maxId);
+}
+
+std::string HistoryStore::segmentPath(const Conversation& conv, uint32_t number, const char* ext) const {
+    char name[32];
+    sprintf_s(name, sizeof(name), "%06u.%s", number, ext);
+    return conv.dir + "/" + name;
+}
+
+HistoryStore::ConversationPtr HistoryStore::open(const std::string& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ConversationPtr& conv = m_conversations[key];
+    if (!conv) {
+        conv = std::make_shared<Conversation>();
+        conv->dir = key;
+    }
+    return conv;
+}
+
+// ====================================================================
+// 追加句柄
+// ====================================================================
+
+// 调用方需已持有 conv.mutex；读段文件之前也要先刷出，否则读不到缓冲里的记录
+// 句柄已被缓存淘汰时数据在关闭时已经写出
+void HistoryStore::flushTailLocked(Conversation& conv, bool sync) {
+    if (conv.tailNumber == 0) return;
+    FileHandlePtr file = m_files.find(segmentPath(conv, conv.tailNumber, "seg"));
+    if (!file) return;
+    if (sync) file->sync();
+    else file->flush();
+}
+
+// 调用方需已持有 conv.mutex
+void HistoryStore::closeTailLocked(Conversation& conv, bool sync) {
+    if (conv.tailNumber == 0) return;
+    m_files.close(segmentPath(conv, conv.tailNumber, "seg"), sync);
+    conv.tailNumber = 0;
+}
+
+void HistoryStore::flush(bool sync) {
+    std::vector<ConversationPtr> convs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        convs.swap(m_toFlush);
+        if (sync) {
+            convs.insert(convs.end(), m_toSync.begin(), m_toSync.end());
+            m_toSync.clear();
+        }
+    }
+    for (const ConversationPtr& conv : convs) {
+        std::lock_guard<std::mutex> lock(conv->mutex);
+        conv->pendingFlush = false;
+        if (sync) conv->pendingSync = false;
+        flushTailLocked(*conv, sync);
+    }
+}
+
+// ====================================================================
+// 加载与恢复
+// ====================================================================
+
+void HistoryStore::loadLocked(Conversation& conv) {
+    conv.loaded = true;
+    conv.segments.clear();
+    conv.nextSeq = 0;
+    conv.lastId = 0;
+
+    std::ifstream ifs(conv.dir + "/MANIFEST");
+    if (!ifs.is_open()) {
+        // 没有 MANIFEST：要么是新会话，要么还是旧的文本记录
+        std::string legacyPath = conv.dir + ".txt";
+        std::error_code ec;
+        if (fs::exists(legacyPath, ec)) importLegacyLocked(conv, legacyPath);
+        noteId(conv.lastId);
+        return;
+    }
+
+    std::string line;
+    std::getline(ifs, line);
+    while (std::getline(ifs, line)) {
+        std::istringstream ss(line);
+        Segment seg;
+        if (ss >> seg.number >> seg.firstSeq >> seg.firstId) conv.segments.push_back(seg);
+    }
+
+    for (size_t i = 0; i < conv.segments.size(); ++i) {
+        bool isLast = (i + 1 == conv.segments.size());
+        if (!isLast) conv.segments[i].count = conv.segments[i + 1].firstSeq - conv.segments[i].firstSeq;
+        loadSegment(conv, conv.segments[i], isLast);
+    }
+    if (!conv.segments.empty()) {
+        const Segment& last = conv.segments.back();
+        conv.nextSeq = last.firstSeq + last.count;
+    }
+    loadTombstones(conv);
+    noteId(conv.lastId);
+}
+
+void HistoryStore::noteId(MessageId id) {
+    MessageId seen = m_maxSeenId.load();
+    while (id > seen && !m_maxSeenId.compare_exchange_weak(seen, id)) {
+    }
+}
+
+MessageId HistoryStore::recover() {
+    for (const char* root : { "GroupRecord", "FriendRecord" }) {
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(root, ec)) {
+            if (!entry.is_directory(ec) || !fs::exists(entry.path() / "MANIFEST", ec)) continue;
+            ConversationPtr conv = open(std::string(root) + "/" + entry.path().filename().string());
+            std::lock_guard<std::mutex> lock(conv->mutex);
+            if (!conv->loaded) loadLocked(*conv);
+        }
+    }
+    return m_maxSeenId;
+}
+
+void HistoryStore::loadTombstones(Conversation& conv) {
+    m_pendingTombstones -= conv.tombstoneCount;
+    conv.tombstones.clear();
+    conv.tombstoneCount = 0;
+
+    // 写了一半的尾部条目读不满，自然被忽略；重复条目在合并时去重
+    std::ifstream ifs(conv.dir + "/TOMBSTONES", std::ios::binary);
+    Tombstone t;
+    while (ifs.read((char*)&t, sizeof(t))) {
+        if (t.seq >= conv.nextSeq) continue;
+        conv.tombstones[t.seq].push_back(t.userId);
+        conv.tombstoneCount++;
+    }
+    m_pendingTombstones += conv.tombstoneCount;
+}
+
+// 调用方需已持有 conv.mutex
+void HistoryStore::ensureHidden(Conversation& conv) {
+    if (conv.hiddenLoaded) return;
+    conv.hiddenLoaded = true;
+    conv.hidden.clear();
+
+    if (!loadHiddenFile(conv)) {
+        flushTailLocked(conv, false);
+        // 没有或损坏 (例如刚从旧文本导入)：扫描一遍段文件里的删除信息，只读头部和删除列表
+        RecordHeader h;
+        for (const Segment& seg : conv.segments) {
+            std::ifstream in(segmentPath(conv, seg.number, "seg"), std::ios::binary);
+            for (uint64_t i = 0; i < seg.count && readHeader(in, h); ++i) {
+                if (h.hiddenCount == 0) {
+                    skipBody(in, h);
+                    continue;
+                }
+                in.seekg(h.length - sizeof(h) - h.hiddenCount * sizeof(int32_t), std::ios::cur);
+                for (uint32_t k = 0; k < h.hiddenCount; ++k) {
+                    int32_t uid = 0;
+                    in.read((char*)&uid, sizeof(uid));
+                    conv.hidden[uid].add(h.seq);
+                }
+            }
+        }
+        writeHiddenFile(conv);
+    }
+
+    for (const auto& pair : conv.tombstones) {
+        for (int uid : pair.second) conv.hidden[uid].add(pair.first);
+    }
+}
+
+// 格式：魔数、用户数，然后每个用户：用户 ID、个数、升序序号
+bool HistoryStore::loadHiddenFile(Conversation& conv) {
+    std::ifstream ifs(conv.dir + "/HIDDEN", std::ios::binary);
+    if (!ifs.is_open()) return conv.segments.empty();
+
+    uint32_t magic = 0, users = 0;
+    if (!ifs.read((char*)&magic, sizeof(magic)) || magic != kHiddenMagic) return false;
+    if (!ifs.read((char*)&users, sizeof(users))) return false;
+    for (uint32_t u = 0; u < users; ++u) {
+        int32_t uid = 0;
+        uint32_t count = 0;
+        if (!ifs.read((char*)&uid, sizeof(uid)) || !ifs.read((char*)&count, sizeof(count))) return false;
+        std::vector<uint64_t> seqs(count);
+        if (count && !ifs.read((char*)seqs.data(), (std::streamsize)(count * sizeof(uint64_t)))) return false;
+        SeqBitmap& bm = conv.hidden[uid];
+        for (uint64_t seq : seqs) {
+            if (seq < conv.nextSeq) bm.add(seq);    // 尾部被截断过的序号丢弃
+        }
+    }
+    return true;
+}
+
+bool HistoryStore::writeHiddenFile(const Conversation& conv) {
+    if (conv.segments.empty()) return true;
+    std::string path = conv.dir + "/HIDDEN";
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) return false;
+        uint32_t users = (uint32_t)conv.hidden.size();
+        ofs.write((const char*)&kHiddenMagic, sizeof(kHiddenMagic));
+        ofs.write((const char*)&users, sizeof(users));
+        for (const auto& pair : conv.hidden) {
+            std::vector<uint64_t> seqs = pair.second.toVector();
+            int32_t uid = pair.first;
+            uint32_t count = (uint32_t)seqs.size();
+            ofs.write((const char*)&uid, sizeof(uid));
+            ofs.write((const char*)&count, sizeof(count));
+            ofs.write((const char*)seqs.data(), (std::streamsize)(count * sizeof(uint64_t)));
+        }
+        if (!ofs.good()) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
+
+void HistoryStore::loadSegment(Conversation& conv, Segment& seg, bool isLast) {
+    std::string segPath = segmentPath(conv, seg.number, "seg");
+    std::error_code ec;
+    uint64_t fileBytes = fs::exists(segPath, ec) ? (uint64_t)fs::file_size(segPath, ec) : 0;
+    seg.bytes = fileBytes;
+
+    std::ifstream idx(segmentPath(conv, seg.number, "idx"), std::ios::binary);
+    IndexEntry e;
+    while (idx.read((char*)&e, sizeof(e))) seg.index.push_back(e);
+
+    // 只要校验最后一项：段被改写过时，改动之后的偏移全都会变，最后一项一定不再对得上
+    bool valid = true;
+    if (!seg.index.empty()) {
+        const IndexEntry& back = seg.index.back();
+        RecordHeader h;
+        std::ifstream in(segPath, std::ios::binary);
+        in.seekg((std::streamoff)back.offset);
+        valid = back.offset < fileBytes && seg.index.front().offset == 0
+            && readHeader(in, h) && h.seq == back.seq && h.id == back.id;
+    }
+    if (!valid) seg.index.clear();
+
+    if (!isLast) {
+        if (!valid) {
+            scanSegment(conv, seg, 0, seg.firstSeq, fileBytes);
+            writeIndex(conv, seg, 0, true);
+        }
+        return;
+    }
+
+    // 活动段：从最后一个索引项往后扫描，补齐索引、统计条数、截掉写了一半的尾部
+    size_t known = seg.index.size();
+    uint64_t offset = known ? seg.index.back().offset : 0;
+    uint64_t seq = known ? seg.index.back().seq : seg.firstSeq;
+    if (known) seg.index.pop_back();    // 扫描时会重新加入
+    uint64_t end = scanSegment(conv, seg, offset, seq, fileBytes);
+
+    if (end < fileBytes) {
+        fs::resize_file(segPath, end, ec);
+        seg.bytes = end;
+    }
+    if (valid) writeIndex(conv, seg, known, false);
+    else writeIndex(conv, seg, 0, true);
+}
+
+// 从 offset (序号为 seq 的记录) 开始顺序扫描到文件尾，补充索引项
+// 返回最后一条完整记录之后的偏移；seg.count 和 conv.lastId 随之更新
+uint64_t HistoryStore::scanSegment(Conversation& conv, Segment& seg, uint64_t offset, uint64_t seq, uint64_t fileBytes) {
+    std::ifstream in(segmentPath(conv, seg.number, "seg"), std::ios::binary);
+    in.seekg((std::streamoff)offset);
+
+    RecordHeader h;
+    while (offset + sizeof(h) <= fileBytes && readHeader(in, h)) {
+        if (h.seq != seq || offset + h.length > fileBytes) break;
+        if ((seq - seg.firstSeq) % kIndexInterval == 0) seg.index.push_back({ seq, h.id, offset });
+        conv.lastId = h.id;
+        offset += h.length;
+        ++seq;
+        skipBody(in, h);
+    }
+    seg.count = seq - seg.firstSeq;
+    return offset;
+}
+
+void HistoryStore::writeIndex(const Conversation& conv, const Segment& seg, size_t from, bool truncate) {
+    if (!truncate && from >= seg.index.size()) return;
+    std::ofstream ofs(segmentPath(conv, seg.number, "idx"),
+        std::ios::binary | (truncate ? std::ios::trunc : std::ios::app));
+    for (size_t i = from; i < seg.index.size(); ++i) {
+        ofs.write((const char*)&seg.index[i], sizeof(IndexEntry));
+    }
+}
+
+bool HistoryStore::writeManifest(const Conversation& conv) {
+    std::string path = conv.dir + "/MANIFEST";
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::trunc);
+        if (!ofs.is_open()) return false;
+        ofs << kManifestHeader << "\n";
+        for (const Segment& seg : conv.segments) {
+            ofs << seg.number << " " << seg.firstSeq << " " << seg.firstId << "\n";
+        }
+        if (!ofs.good()) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
+
+HistoryStore::Segment& HistoryStore::addSegment(Conversation& conv, uint64_t firstSeq, MessageId firstId) {
+    Segment seg;
+    seg.number = conv.segments.empty() ? 1 : conv.segments.back().number + 1;
+    seg.firstSeq = firstSeq;
+    seg.firstId = firstId;
+    conv.segments.push_back(seg);
+    return conv.segments.back();
+}
+
+// 旧文本格式：时间|发送者ID|发送者|内容|UUID|删除标记
+// 一次性批量写入新段，最后写 MANIFEST 作为提交点，再把旧文件改名
+void HistoryStore::importLegacyLocked(Conversation& conv, const std::string& legacyPath) {
+    std::ifstream ifs(legacyPath);
+    if (!ifs.is_open()) return;
+
+    // 清掉上次导入中断留下的半成品 (没有 MANIFEST 的段文件都未提交)
+    std::error_code ec;
+    fs::create_directories(conv.dir, ec);
+    for (const auto& entry : fs::directory_iterator(conv.dir, ec)) {
+        std::string ext = entry.path().extension().string();
+        std::string name = entry.path().filename().string();
+        if (ext == ".seg" || ext == ".idx" || ext == ".tmp" || name == "HIDDEN" || name == "TOMBSTONES") fs::remove(entry.path(), ec);
+    }
+
+    std::ofstream seg, idx;
+    std::string buf;
+    uint32_t legacySeq = 0;
+    std::string line;
+
+    while (std::getline(ifs, line)) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) line.pop_back();
+        if (line.empty()) continue;
+
+        std::stringstream ss(line);
+        std::string segment;
+        std::vector<std::string> parts;
+        while (std::getline(ss, segment, '|')) parts.push_back(segment);
+        if (parts.size() < 5) continue;
+
+        HistoryRecord rec;
+        rec.time = parts[0];
+        rec.senderId = atoi(parts[1].c_str());
+        rec.senderName = parts[2];
+        rec.content = parts[3];
+        if (parts.size() >= 6) rec.hiddenFor = parseLegacyDeletes(parts[5]);
+
+        // 新格式 ID 直接沿用；旧的 "<秒>-<随机数>" 按秒数合成，节点号 0
+        MessageId id = 0;
+        if (!MessageIdGenerator::parse(parts[4], id)) {
+            long long sec = atoll(parts[4].c_str());
+            id = MessageIdGenerator::compose(sec * 1000, 0, legacySeq++);
+        }
+        rec.id = std::max(id, conv.lastId + 1);
+        rec.seq = conv.nextSeq;
+
+        if (conv.segments.empty() || conv.segments.back().bytes >= kSegmentBytes) {
+            if (seg.is_open()) { seg.write(buf.data(), buf.size()); buf.clear(); seg.close(); idx.close(); }
+            Segment& s = addSegment(conv, rec.seq, rec.id);
+            seg.open(segmentPath(conv, s.number, "seg"), std::ios::binary | std::ios::trunc);
+            idx.open(segmentPath(conv, s.number, "idx"), std::ios::binary | std::ios::trunc);
+        }
+
+        Segment& cur = conv.segments.back();
+        if ((rec.seq - cur.firstSeq) % kIndexInterval == 0) {
+            IndexEntry e = { rec.seq, rec.id, cur.bytes };
+            cur.index.push_back(e);
+            idx.write((const char*)&e, sizeof(e));
+        }
+        size_t before = buf.size();
+        encodeRecord(rec, buf);
+        cur.bytes += buf.size() - before;
+        cur.count++;
+        conv.nextSeq++;
+        conv.lastId = rec.id;
+
+        if (buf.size() >= 256 * 1024) { seg.write(buf.data(), buf.size()); buf.clear(); }
+    }
+    if (seg.is_open()) { seg.write(buf.data(), buf.size()); seg.close(); idx.close(); }
+    ifs.close();
+
+    if (conv.segments.empty() || !writeManifest(conv)) return;
+    fs::rename(legacyPath, legacyPath + ".imported", ec);
+}
+
+// ====================================================================
+// 定位
+// ====================================================================
+
+size_t HistoryStore::segmentForSeq(const Conversation& conv, uint64_t seq) const {
+    auto it = std::upper_bound(conv.segments.begin(), conv.segments.end(), seq,
+        [](uint64_t s, const Segment& seg) { return s < seg.firstSeq; });
+    return it == conv.segments.begin() ? 0 : (size_t)(it - conv.segments.begin()) - 1;
+}
+
+// 第一条 ID >= id 的记录序号 (都小于 id 时返回 nextSeq)，foundId 返回该记录的 ID
+// 先按段首 ID 二分，再按稀疏索引二分，最后最多顺序扫描 kIndexInterval 条
+uint64_t HistoryStore::lowerBoundSeq(Conversation& conv, MessageId id, MessageId* foundId) {
+    auto segIt = std::lower_bound(conv.segments.begin(), conv.segments.end(), id,
+        [](const Segment& seg, MessageId v) { return seg.firstId < v; });
+    if (segIt == conv.segments.begin()) return 0;
+    const Segment& seg = *(segIt - 1);
+    uint64_t segEnd = seg.firstSeq + seg.count;
+    flushTailLocked(conv, false);
+
+    auto idxIt = std::lower_bound(seg.index.begin(), seg.index.end(), id,
+        [](const IndexEntry& e, MessageId v) { return e.id < v; });
+    uint64_t offset = 0, seq = seg.firstSeq;
+    if (idxIt != seg.index.begin()) {
+        offset = (idxIt - 1)->offset;
+        seq = (idxIt - 1)->seq;
+    }
+
+    std::ifstream in(segmentPath(conv, seg.number, "seg"), std::ios::binary);
+    in.seekg((std::streamoff)offset);
+    RecordHeader h;
+    while (seq < segEnd && readHeader(in, h)) {
+        if (h.id >= id) {
+            if (foundId) *foundId = h.id;
+            return h.seq;
+        }
+        skipBody(in, h);
+        ++seq;
+    }
+    return segEnd;
+}
+
+std::vector<HistoryRecord> HistoryStore::readRange(Conversation& conv, uint64_t beginSeq, uint64_t endSeq, int viewerId) {
+    std::vector<HistoryRecord> result;
+    if (beginSeq >= endSeq || conv.segments.empty()) return result;
+    flushTailLocked(conv, false);
+
+    const SeqBitmap* hidden = nullptr;
+    if (viewerId != 0) {
+        ensureHidden(conv);
+        auto it = conv.hidden.find(viewerId);
+        if (it != conv.hidden.end()) hidden = &it->second;
+    }
+    result.reserve((size_t)(endSeq - beginSeq));
+
+    std::vector<char> ioBuf(64 * 1024);
+    for (size_t si = segmentForSeq(conv, beginSeq); si < conv.segments.size(); ++si) {
+        const Segment& seg = conv.segments[si];
+        if (seg.firstSeq >= endSeq) break;
+        uint64_t segEnd = std::min(endSeq, seg.firstSeq + seg.count);
+
+        // 用稀疏索引跳到不晚于 beginSeq 的最近位置
+        uint64_t offset = 0, seq = seg.firstSeq;
+        if (beginSeq > seg.firstSeq && !seg.index.empty()) {
+            size_t k = std::min<size_t>((size_t)((beginSeq - seg.firstSeq) / kIndexInterval), seg.index.size() - 1);
+            offset = seg.index[k].offset;
+            seq = seg.index[k].seq;
+        }
+
+        std::ifstream in;
+        in.rdbuf()->pubsetbuf(ioBuf.data(), (std::streamsize)ioBuf.size());
+        in.open(segmentPath(conv, seg.number, "seg"), std::ios::binary);
+        in.seekg((std::streamoff)offset);
+
+        RecordHeader h;
+        while (seq < segEnd && readHeader(in, h) && h.seq == seq) {
+            if (seq < beginSeq || (hidden && hidden->contains(seq))) {
+                skipBody(in, h);
+            }
+            else {
+                HistoryRecord rec;
+                if (!readBody(in, h, rec)) break;
+                // 合并尚未落到段文件里的删除
+                auto it = conv.tombstones.find(seq);
+                if (it != conv.tombstones.end()) {
+                    for (int uid : it->second) {
+                        if (!rec.isHiddenFor(uid)) rec.hiddenFor.push_back(uid);
+                    }
+                }
+                result.push_back(std::move(rec));
+            }
+            ++seq;
+        }
+    }
+    return result;
+}
+
+// ====================================================================
+// 对外接口
+// ====================================================================
+
+bool HistoryStore::append(const std::string& key, HistoryRecord& rec) {
+    ConversationPtr conv = open(key);
+    std::lock_guard<std::mutex> lock(conv->mutex);
+    if (!conv->loaded) loadLocked(*conv);
+
+    // 二分定位和稀疏索引都依赖 ID 递增；生成器启动时已越过所有已存储的 ID，这里只是兜底，不写坏游标翻页
+    if (rec.id <= conv->lastId) {
+        std::cout << "[Error] History " << key << ": rejected out-of-order message id "
+                  << rec.id << " (last " << conv->lastId << ")" << std::endl;
+        return false;
+    }
+
+    if (conv->segments.empty() || conv->segments.back().bytes >= kSegmentBytes) {
+        std::error_code ec;
+        fs::create_directories(conv->dir, ec);
+        addSegment(*conv, conv->nextSeq, rec.id);
+        if (!writeManifest(*conv)) {
+            conv->segments.pop_back();
+            return false;
+        }
+    }
+
+    Segment& seg = conv->segments.back();
+    rec.seq = conv->nextSeq;
+    std::string buf;
+    encodeRecord(rec, buf);
+
+    // 换段时旧段不再追加，先落盘再关闭
+    if (conv->tailNumber != 0 && conv->tailNumber != seg.number) closeTailLocked(*conv, true);
+    FileHandlePtr file = m_files.acquire(segmentPath(*conv, seg.number, "seg"));
+    if (!file) return false;
+    conv->tailNumber = seg.number;
+    if (!file->write(buf.data(), buf.size())) {
+        closeTailLocked(*conv, false);
+        return false;
+    }
+    if (!conv->pendingFlush || !conv->pendingSync) {
+        std::lock_guard<std::mutex> listLock(m_mutex);
+        if (!conv->pendingFlush) m_toFlush.push_back(conv);
+        if (!conv->pendingSync) m_toSync.push_back(conv);
+        conv->pendingFlush = conv->pendingSync = true;
+    }
+
+    if ((rec.seq - seg.firstSeq) % kIndexInterval == 0) {
+        seg.index.push_back({ rec.seq, rec.id, seg.bytes });
+        writeIndex(*conv, seg, seg.index.size() - 1, false);
+    }
+    seg.bytes += buf.size();
+    seg.count++;
+    conv->nextSeq++;
+    conv->lastId = rec.id;
+    noteId(rec.id);
+    m_cache.append(key, rec);
+    return true;
+}
+
+std::vector<HistoryRecord> HistoryStore::readBefore(const std::string& key, MessageId beforeId, size_t limit,
+    int viewerId, MessageId* nextCursor) {
+    std::vector<HistoryRecord> result;
+    MessageId cursor = 0;
+    if (m_cache.readBefore(key, beforeId, limit, viewerId, result, cursor)) {
+        if (nextCursor) *nextCursor = cursor;
+        return result;
+    }
+
+    ConversationPtr conv = open(key);
+    std::lock_guard<std::mutex> lock(conv->mutex);
+    if (!conv->loaded) loadLocked(*conv);
+
+    // 第一次读取：把最新的一环装进缓存再试一次；环外的翻页直接读存储
+    if (!m_cache.contains(key)) {
+        size_t ring = m_cache.getRingSize();
+        uint64_t beginSeq = (conv->nextSeq > ring) ? conv->nextSeq - ring : 0;
+        m_cache.fill(key, readRange(*conv, beginSeq, conv->nextSeq));
+        if (m_cache.readBefore(key, beforeId, limit, viewerId, result, cursor, false)) {
+            if (nextCursor) *nextCursor = cursor;
+            return result;
+        }
+    }
+
+    uint64_t endSeq = (beforeId == 0) ? conv->nextSeq : lowerBoundSeq(*conv, beforeId);
+    result.clear();
+    // 被 viewer 删掉的记录不计数，不够就再往前读一段
+    while (result.size() < limit && endSeq > 0) {
+        size_t need = limit - result.size();
+        uint64_t beginSeq = (endSeq > need) ? endSeq - need : 0;
+        std::vector<HistoryRecord> chunk = readRange(*conv, beginSeq, endSeq, viewerId);
+        result.insert(result.begin(), std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.end()));
+        endSeq = beginSeq;
+    }
+
+    if (nextCursor) {
+        *nextCursor = 0;
+        if (endSeq > 0) {
+            std::vector<HistoryRecord> first = readRange(*conv, endSeq, endSeq + 1);
+            if (!first.empty()) *nextCursor = first[0].id;
+        }
+    }
+    return result;
+}
+
+uint64_t HistoryStore::getMessageCount(const std::string& key) {
+    ConversationPtr conv = open(key);
+    std::lock_guard<std::mutex> lock(conv->mutex);
+    if (!conv->loaded) loadLocked(*conv);
+    return conv->nextSeq;
+}
+
+bool HistoryStore::hideMessage(const std::string& key, MessageId id, int userId) {
+    ConversationPtr conv = open(key);
+    std::lock_guard<std::mutex> lock(conv->mutex);
+    if (!conv->loaded) loadLocked(*conv);
+
+    MessageId found = 0;
+    uint64_t seq = lowerBoundSeq(*conv, id, &found);
+    if (seq >= conv->nextSeq || found != id) return false;
+
+    std::vector<int>& users = conv->tombstones[seq];
+    if (std::find(users.begin(), users.end(), userId) != users.end()) return true;
+
+    Tombstone t = { seq, id, userId };
+    std::ofstream ofs(conv->dir + "/TOMBSTONES", std::ios::binary | std::ios::app);
+    if (!ofs.is_open()) return false;
+    ofs.write((const char*)&t, sizeof(t));
+    ofs.close();
+    if (ofs.fail()) return false;
+
+    users.push_back(userId);
+    if (conv->hiddenLoaded) conv->hidden[userId].add(seq);
+    m_cache.hide(key, id, userId);
+    conv->tombstoneCount++;
+    m_pendingTombstones++;
+    if (conv->tombstoneCount >= kCompactThreshold) {
+        m_compactRequested = true;
+        m_wakeCv.notify_one();
+    }
+    return true;
+}
+
+// ====================================================================
+// 后台合并：把删除日志并入段文件，然后清空日志
+// ====================================================================
+
+void HistoryStore::compactLoop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wakeCv.wait_for(lock, std::chrono::seconds(kCompactIntervalSec),
+                [this] { return m_compactRequested || !m_running; });
+        }
+        m_compactRequested = false;
+        bool exiting = !m_running;
+
+        std::vector<ConversationPtr> convs;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& pair : m_conversations) convs.push_back(pair.second);
+        }
+        for (const ConversationPtr& conv : convs) {
+            std::lock_guard<std::mutex> lock(conv->mutex);
+            if (conv->loaded && conv->tombstoneCount > 0) compact(*conv);
+        }
+        if (exiting) break;
+    }
+}
+
+// 调用方需已持有 conv.mutex
+void HistoryStore::compact(Conversation& conv) {
+    std::vector<size_t> touched;
+    for (const auto& pair : conv.tombstones) {
+        size_t si = segmentForSeq(conv, pair.first);
+        if (std::find(touched.begin(), touched.end(), si) == touched.end()) touched.push_back(si);
+    }
+    for (size_t si : touched) {
+        // 任一段改写失败就保留日志，下次再来；已改写的段重复应用是幂等的
+        if (!rewriteSegment(conv, si)) return;
+    }
+    // HIDDEN 必须在清空日志之前落盘，否则崩溃后会丢掉这批删除
+    ensureHidden(conv);
+    if (!writeHiddenFile(conv)) return;
+
+    std::ofstream ofs(conv.dir + "/TOMBSTONES", std::ios::binary | std::ios::trunc);
+    m_pendingTombstones -= conv.tombstoneCount;
+    conv.tombstones.clear();
+    conv.tombstoneCount = 0;
+}
+
+// 改写一个段，把落在其中的删除日志写进记录 (段大小有上限，代价有界)
+// 先写临时文件再改名；索引最后改名，中途崩溃时加载阶段会发现索引对不上并重建
+bool HistoryStore::rewriteSegment(Conversation& conv, size_t segIdx) {
+    Segment& seg = conv.segments[segIdx];
+    // readRange 已经合并了删除日志
+    std::vector<HistoryRecord> records = readRange(conv, seg.firstSeq, seg.firstSeq + seg.count);
+    if (records.size() != seg.count) return false;
+    std::string buf;
+    std::vector<IndexEntry> index;
+    for (const HistoryRecord& rec : records) {
+        if ((rec.seq - seg.firstSeq) % kIndexInterval == 0) index.push_back({ rec.seq, rec.id, (uint64_t)buf.size() });
+        encodeRecord(rec, buf);
+    }
+
+    std::string segPath = segmentPath(conv, seg.number, "seg");
+    std::string idxPath = segmentPath(conv, seg.number, "idx");
+    // 追加句柄指向旧文件，改名前关闭，下次追加时重新打开
+    if (conv.tailNumber == seg.number) closeTailLocked(conv, false);
+    {
+        std::ofstream ofs(segPath + ".tmp", std::ios::binary | std::ios::trunc);
+        ofs.write(buf.data(), (std::streamsize)buf.size());
+        if (!ofs.good()) return false;
+        std::ofstream idx(idxPath + ".tmp", std::ios::binary | std::ios::trunc);
+        idx.write((const char*)index.data(), (std::streamsize)(index.size() * sizeof(IndexEntry)));
+        if (!idx.good()) return false;
+    }
+    std::error_code ec;
+    fs::rename(segPath + ".tmp", segPath, ec);
+    if (ec) return false;
+    fs::rename(idxPath + ".tmp", idxPath, ec);
+
+    seg.bytes = buf.size();
+    seg.index.swap(index);
+    return true;
+}
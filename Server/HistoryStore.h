@@ -0,0 +1,162 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <condition_variable>
+#include <cstdint>
+#include <unordered_map>
+#include "MessageId.h"
+#include "SeqBitmap.h"
+#include "HistoryCache.h"
+#include "FileHandleCache.h"
+
+// ====================================================================
+// HistoryStore：聊天记录存储引擎
+// 每个会话一个目录 (GroupRecord/<群名>/、FriendRecord/<小ID>_<大ID>/)，其中：
+//   MANIFEST      段列表：段号、首条序号、首条消息 ID
+//   000001.seg    只追加的记录段，定长二进制头 + 变长字段
+//   000001.idx    稀疏索引，每 kIndexInterval 条记录一项 (序号、消息 ID、段内偏移)
+//   TOMBSTONES    删除日志，每条 (序号、消息 ID、用户 ID)，读取时合并，后台定期并入段文件
+//   HIDDEN        每个用户删除过的消息序号，合并删除日志时重写；读取时按用户过滤只需查位图
+// 读取历史时先按 MANIFEST 和索引定位，再从该偏移连续读取，不再逐行解析整个文件
+// 旧的 <会话>.txt 在第一次访问时导入，导入后改名为 .txt.imported
+// 追加句柄取自共享的 FileHandleCache，写入先进缓冲，由 flush() 统一交给操作系统 / fsync
+// ====================================================================
+
+struct HistoryRecord {
+    MessageId id = 0;
+    uint64_t seq = 0;           // 会话内从 0 开始的连续序号
+    int senderId = 0;
+    std::string senderName;
+    std::string content;
+    std::string time;
+    std::vector<int> hiddenFor; // 已各自删除这条消息的用户
+
+    bool isHiddenFor(int userId) const;
+};
+
+class HistoryStore {
+public:
+    explicit HistoryStore(FileHandleCache& files);
+    ~HistoryStore();
+
+    // 后台合并删除日志的线程
+    void start();
+    void stop();
+
+    // 启动时加载磁盘上已有 MANIFEST 的全部会话 (顺带截掉写了一半的尾部)，返回见过的最大消息 ID
+    // 在写线程启动前调用，用来抬高 MessageIdGenerator
+    MessageId recover();
+    MessageId getMaxSeenId() const { return m_maxSeenId; }
+
+    // 会话键即会话目录；旧文本文件为 键 + ".txt"
+    static std::string groupKey(const std::string& groupName);
+    static std::string friendKey(int id1, int id2);
+
+    // 追加一条记录并填写 rec.seq；同一会话内 rec.id 需递增 (生成器已按 recover() 抬高)，不大于上一条时拒绝并返回 false
+    // 数据留在句柄缓冲里，本进程内的读取会先刷出；要求落盘时调用 flush
+    bool append(const std::string& key, HistoryRecord& rec);
+
+    // 把上次以来有追加的会话刷给操作系统；sync 为 true 时再 fsync 所有未同步的会话
+    void flush(bool sync);
+    FileHandleCache& files() { return m_files; }
+
+    // 取 id < beforeId 的最近 limit 条 (beforeId 为 0 表示从最新一条往前)，按时间顺序返回
+    // viewerId 非 0 时跳过该用户删除过的记录，并继续往前补足 limit 条
+    // nextCursor 返回下一页要传入的 beforeId，0 表示已经没有更早的记录
+    std::vector<HistoryRecord> readBefore(const std::string& key, MessageId beforeId, size_t limit,
+        int viewerId = 0, MessageId* nextCursor = nullptr);
+
+    // 对 userId 隐藏一条消息；只追加一条删除日志，找不到该消息时返回 false
+    bool hideMessage(const std::string& key, MessageId id, int userId);
+
+    uint64_t getMessageCount(const std::string& key);
+    uint64_t getPendingTombstones() const { return m_pendingTombstones; }
+    const HistoryCache& cache() const { return m_cache; }
+
+    static constexpr size_t kSegmentBytes = 4 * 1024 * 1024;
+    static constexpr uint64_t kIndexInterval = 64;
+    static constexpr size_t kCompactThreshold = 256;   // 单个会话积压到这么多条时立即合并
+    static constexpr int kCompactIntervalSec = 30;     // 否则按这个周期合并
+
+private:
+    struct IndexEntry {
+        uint64_t seq;
+        MessageId id;
+        uint64_t offset;
+    };
+
+    struct Segment {
+        uint32_t number = 0;
+        uint64_t firstSeq = 0;
+        MessageId firstId = 0;
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+        std::vector<IndexEntry> index;
+    };
+
+    struct Conversation {
+        std::mutex mutex;
+        std::string dir;
+        bool loaded = false;
+        std::vector<Segment> segments;
+        uint64_t nextSeq = 0;
+        MessageId lastId = 0;
+        // 尚未并入段文件的删除：序号 -> 用户
+        std::unordered_map<uint64_t, std::vector<int>> tombstones;
+        size_t tombstoneCount = 0;
+        // 用户 -> 其删除过的序号；第一次按用户过滤时才加载，之后常驻
+        bool hiddenLoaded = false;
+        std::unordered_map<int, SeqBitmap> hidden;
+        // 最近一次追加所在的段 (0 表示没有)，其句柄缓冲里可能有尚未写出的记录
+        uint32_t tailNumber = 0;
+        bool pendingFlush = false;      // 已在 m_toFlush 中
+        bool pendingSync = false;       // 已在 m_toSync 中
+    };
+    typedef std::shared_ptr<Conversation> ConversationPtr;
+
+    ConversationPtr open(const std::string& key);
+
+    // 以下均要求调用方持有 conv.mutex
+    void loadLocked(Conversation& conv);
+    void flushTailLocked(Conversation& conv, bool sync);
+    void closeTailLocked(Conversation& conv, bool sync);
+    void loadTombstones(Conversation& conv);
+    void ensureHidden(Conversation& conv);
+    bool loadHiddenFile(Conversation& conv);
+    bool writeHiddenFile(const Conversation& conv);
+    void importLegacyLocked(Conversation& conv, const std::string& legacyPath);
+    void loadSegment(Conversation& conv, Segment& seg, bool isLast);
+    uint64_t scanSegment(Conversation& conv, Segment& seg, uint64_t offset, uint64_t seq, uint64_t fileBytes);
+    void writeIndex(const Conversation& conv, const Segment& seg, size_t from, bool truncate);
+    bool writeManifest(const Conversation& conv);
+    Segment& addSegment(Conversation& conv, uint64_t firstSeq, MessageId firstId);
+    size_t segmentForSeq(const Conversation& conv, uint64_t seq) const;
+    uint64_t lowerBoundSeq(Conversation& conv, MessageId id, MessageId* foundId = nullptr);
+    std::vector<HistoryRecord> readRange(Conversation& conv, uint64_t beginSeq, uint64_t endSeq, int viewerId = 0);
+    bool rewriteSegment(Conversation& conv, size_t segIdx);
+    void compact(Conversation& conv);
+    void compactLoop();
+    void noteId(MessageId id);
+
+    std::string segmentPath(const Conversation& conv, uint32_t number, const char* ext) const;
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, ConversationPtr> m_conversations;
+    std::vector<ConversationPtr> m_toFlush;     // 上次 flush 以来有追加的会话
+    std::vector<ConversationPtr> m_toSync;      // 上次 fsync 以来有追加的会话
+    FileHandleCache& m_files;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+    std::atomic<bool> m_compactRequested{ false };
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCv;
+    std::atomic<uint64_t> m_pendingTombstones{ 0 };
+    std::atomic<MessageId> m_maxSeenId{ 0 };    // 已加载或追加过的会话中最大的消息 ID
+
+    HistoryCache m_cache;   // 最近消息的内存环，读最新一页时优先命中
+};
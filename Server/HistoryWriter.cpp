@@ -0,0 +1,168 @@
+﻿#include "HistoryWriter.h"
+#include <chrono>
+
+HistoryWriter::HistoryWriter(HistoryStore& store, MessageIdGenerator& ids)
+    : m_store(store)
+    , m_ids(ids)
+{
+}
+
+HistoryWriter::~HistoryWriter() {
+    stop();
+}
+
+void HistoryWriter::start() {
+    if (m_running) return;
+    m_running = true;
+    m_thread = std::thread(&HistoryWriter::threadLoop, this);
+}
+
+void HistoryWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) return;
+        m_running = false;
+    }
+    m_wakeCv.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void HistoryWriter::setDurability(Durability mode, int syncIntervalMs) {
+    m_durability = mode;
+    m_store.files().setSyncOnClose(mode != DURABILITY_NONE);
+    if (syncIntervalMs > 0) m_syncIntervalMs = syncIntervalMs;
+    m_wakeCv.notify_one();
+}
+
+const char* HistoryWriter::durabilityName(Durability mode) {
+    switch (mode) {
+    case DURABILITY_NONE: return "none";
+    case DURABILITY_BATCHED: return "batched";
+    case DURABILITY_STRICT: return "strict";
+    }
+    return "unknown";
+}
+
+bool HistoryWriter::parseDurability(const std::string& name, Durability& mode) {
+    if (name == "none") mode = DURABILITY_NONE;
+    else if (name == "batched") mode = DURABILITY_BATCHED;
+    else if (name == "strict") mode = DURABILITY_STRICT;
+    else return false;
+    return true;
+}
+
+uint64_t HistoryWriter::getPending() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nextTicket - m_applied;
+}
+
+void HistoryWriter::writeItem(Item& item) {
+    if (!m_store.append(item.key, item.rec)) {
+        m_failures++;
+        if (m_onError) m_onError(item.key);
+    }
+}
+
+MessageId HistoryWriter::submit(const std::string& key, HistoryRecord rec) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    rec.id = m_ids.next();
+    MessageId id = rec.id;
+
+    // 写线程未运行 (启动前或已停止) 时退化为同步写入
+    if (!m_running) {
+        Item item = { key, std::move(rec), 0 };
+        writeItem(item);
+        m_store.flush(m_durability != DURABILITY_NONE);
+        return id;
+    }
+
+    uint64_t ticket = ++m_nextTicket;
+    m_lastTicket[key] = ticket;
+    m_queue.push_back({ key, std::move(rec), ticket });
+    bool wasEmpty = (m_queue.size() == 1);
+    if (m_durability == DURABILITY_STRICT) {
+        m_wakeCv.notify_one();
+        m_doneCv.wait(lock, [&] { return m_synced >= ticket || !m_running; });
+    }
+    else if (wasEmpty) {
+        lock.unlock();
+        m_wakeCv.notify_one();
+    }
+    return id;
+}
+
+void HistoryWriter::waitApplied(const std::string& key) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto it = m_lastTicket.find(key);
+    if (it == m_lastTicket.end()) return;
+    uint64_t ticket = it->second;
+    m_doneCv.wait(lock, [&] { return m_applied >= ticket || !m_running; });
+}
+
+// ====================================================================
+// 写线程：一次取走整个队列，追加完统一交给操作系统，按模式决定是否 fsync
+// ====================================================================
+
+void HistoryWriter::threadLoop() {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point lastSync = Clock::now();
+    Clock::time_point lastIdleCheck = lastSync;
+    std::vector<Item> batch;
+    bool unsynced = false;
+
+    for (;;) {
+        bool exiting = false;
+        uint64_t last = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            // batched 模式下有未同步的数据时按周期醒来，否则只为关闭空闲句柄定期醒来
+            int waitMs = (m_durability == DURABILITY_BATCHED && m_applied > m_synced) ? m_syncIntervalMs.load() : 1000;
+            m_wakeCv.wait_for(lock, std::chrono::milliseconds(waitMs),
+                [this] { return !m_queue.empty() || !m_running; });
+            batch.swap(m_queue);
+            exiting = !m_running;
+            last = m_nextTicket;
+        }
+
+        for (Item& item : batch) writeItem(item);
+        if (!batch.empty()) {
+            unsynced = true;
+            m_batches++;
+            // 只交给操作系统就能被读到；先发布 m_applied，翻页的 I/O 线程不等 fsync
+            m_store.flush(false);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_applied = last;
+                // 只剩积压还没写完的会话，表的大小跟队列长度同一量级
+                for (auto it = m_lastTicket.begin(); it != m_lastTicket.end();) {
+                    if (it->second <= last) it = m_lastTicket.erase(it);
+                    else ++it;
+                }
+            }
+            m_doneCv.notify_all();
+        }
+
+        Durability mode = m_durability;
+        Clock::time_point now = Clock::now();
+        bool sync = unsynced && (exiting || mode == DURABILITY_STRICT
+            || (mode == DURABILITY_BATCHED && now - lastSync >= std::chrono::milliseconds(m_syncIntervalMs.load())));
+        if (sync) {
+            m_store.flush(true);
+            lastSync = now;
+            unsynced = false;
+            m_syncs++;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_synced = last;
+            }
+            m_doneCv.notify_all();
+        }
+        if (now - lastIdleCheck >= std::chrono::seconds(1)) {
+            m_store.files().closeIdle(kIdleCloseSec);
+            lastIdleCheck = now;
+        }
+        batch.clear();
+
+        if (exiting) break;
+    }
+}
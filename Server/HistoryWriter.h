@@ -0,0 +1,95 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+#include "MessageId.h"
+#include "HistoryStore.h"
+
+// ====================================================================
+// HistoryWriter：聊天记录的后台写入 (write-behind)
+// 发送线程只入队并拿到消息 ID，追加、刷盘和 fsync 都在专用线程按批完成
+// 落盘方式启动时选择：
+//   none     只交给操作系统，不主动 fsync (退出时同步一次)
+//   batched  每 syncIntervalMs 合并做一次 fsync，默认
+//   strict   每批写完立即 fsync，submit 等到落盘后才返回，之后才下发给接收方
+// ====================================================================
+
+class HistoryWriter {
+public:
+    enum Durability {
+        DURABILITY_NONE = 0,
+        DURABILITY_BATCHED,
+        DURABILITY_STRICT
+    };
+
+    HistoryWriter(HistoryStore& store, MessageIdGenerator& ids);
+    ~HistoryWriter();
+
+    void start();
+    void stop();    // 写完并同步队列中剩余的记录后退出
+
+    void setDurability(Durability mode, int syncIntervalMs);
+    Durability durability() const { return m_durability; }
+    int syncIntervalMs() const { return m_syncIntervalMs; }
+
+    // 写入失败时在写线程回调，参数为会话键
+    void setErrorHandler(std::function<void(const std::string&)> handler) { m_onError = std::move(handler); }
+
+    // 入队一条记录，返回分配给它的消息 ID
+    // ID 在队列锁内生成，保证同一会话的记录按 ID 递增的顺序写入
+    MessageId submit(const std::string& key, HistoryRecord rec);
+
+    // 等待此前入队的、属于 key 这个会话的记录都已写入存储 (不等 fsync)；读历史、删消息之前调用
+    // 只等这个会话最后一条记录的票号，其他会话的积压不影响
+    void waitApplied(const std::string& key);
+
+    uint64_t getPending() const;
+    uint64_t getBatches() const { return m_batches; }
+    uint64_t getSyncs() const { return m_syncs; }
+    uint64_t getFailures() const { return m_failures; }
+
+    static const char* durabilityName(Durability mode);
+    static bool parseDurability(const std::string& name, Durability& mode);
+
+    static constexpr int kDefaultSyncIntervalMs = 100;
+    static constexpr int kIdleCloseSec = 10;    // 共享句柄缓存中这么久没用的句柄由写线程关闭
+
+private:
+    struct Item {
+        std::string key;
+        HistoryRecord rec;
+        uint64_t ticket;
+    };
+
+    void threadLoop();
+    void writeItem(Item& item);
+
+    HistoryStore& m_store;
+    MessageIdGenerator& m_ids;
+    std::function<void(const std::string&)> m_onError;
+
+    std::atomic<Durability> m_durability{ DURABILITY_BATCHED };
+    std::atomic<int> m_syncIntervalMs{ kDefaultSyncIntervalMs };
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeCv;   // 通知写线程
+    std::condition_variable m_doneCv;   // 通知等待写入/落盘的调用方
+    std::vector<Item> m_queue;
+    uint64_t m_nextTicket = 0;          // 已入队
+    uint64_t m_applied = 0;             // 已写入存储
+    uint64_t m_synced = 0;              // 已 fsync
+    // 会话键 -> 该会话最后入队的票号；写入后票号不超过 m_applied 的项由写线程清掉
+    std::unordered_map<std::string, uint64_t> m_lastTicket;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+
+    std::atomic<uint64_t> m_batches{ 0 };
+    std::atomic<uint64_t> m_syncs{ 0 };
+    std::atomic<uint64_t> m_failures{ 0 };
+};
@@ -0,0 +1,39 @@
+﻿#include "JournalReader.h"
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+size_t readJournalLines(const std::string& path, const std::function<void(const std::string& line)>& onLine) {
+    std::ifstream ifs(path, std::ios::in | std::ios::binary);
+    if (!ifs.is_open()) return 0;
+
+    size_t count = 0;
+    bool tornTail = false;
+    std::streamoff validEnd = 0;    // 最后一条完整记录之后的位置
+    std::string line;
+    while (std::getline(ifs, line)) {
+        if (ifs.eof()) {
+            // getline 读到文件尾才停下，这一行没有换行符
+            tornTail = true;
+            break;
+        }
+        validEnd = ifs.tellg();
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        onLine(line);
+        count++;
+    }
+    ifs.close();
+
+    if (tornTail) {
+        std::cout << "[Warning] Dropped incomplete last record in " << path << std::endl;
+        std::error_code ec;
+        std::filesystem::resize_file(path, (uintmax_t)validEnd, ec);
+        if (ec) {
+            // 截不掉时至少补上换行，避免下一条记录接在半行后面
+            std::ofstream ofs(path, std::ios::out | std::ios::app | std::ios::binary);
+            ofs << '\n';
+        }
+    }
+    return count;
+}
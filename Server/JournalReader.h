@@ -0,0 +1,13 @@
+﻿#pragma once
+#include <string>
+#include <functional>
+
+// ====================================================================
+// 只追加的文本日志 (用户、好友、申请、群组) 共用的逐行读取
+// 去掉行尾的 \r、跳过空行，只把以换行结尾的完整记录交给 onLine；
+// 最后一行没有换行符说明上次写到一半：丢弃它并把文件截到上一条完整记录末尾，
+// 之后追加的记录不会接在半行后面，下次启动也不会把半行当成完整记录重放
+// 返回交给 onLine 的行数；文件不存在时返回 0
+// ====================================================================
+
+size_t readJournalLines(const std::string& path, const std::function<void(const std::string& line)>& onLine);
@@ -0,0 +1,36 @@
+﻿#include "LineFramer.h"
+
+LineFramer::LineFramer(size_t maxFrame)
+    : m_maxFrame(maxFrame)
+{
+}
+
+bool LineFramer::feed(const char* data, size_t len, std::vector<std::string>& frames) {
+    m_buf.append(data, len);
+
+    size_t start = 0;
+    size_t pos;
+    while ((pos = m_buf.find('\n', m_scanPos)) != std::string::npos) {
+        size_t end = pos;
+        if (end > start && m_buf[end - 1] == '\r') end--;
+        // 一次读到的完整帧同样受上限约束，之前的帧照常交出
+        if (end - start > m_maxFrame) return false;
+        if (end > start) frames.emplace_back(m_buf, start, end - start);
+        start = pos + 1;
+        m_scanPos = start;
+    }
+
+    if (start > 0) m_buf.erase(0, start);
+    m_scanPos = m_buf.size();
+
+    if (m_buf.size() > m_maxFrame) return false;
+
+    // 空闲连接不长期占着大块缓冲
+    if (m_buf.empty() && m_buf.capacity() > 4096) std::string().swap(m_buf);
+    return true;
+}
+
+void LineFramer::clear() {
+    std::string().swap(m_buf);
+    m_scanPos = 0;
+}
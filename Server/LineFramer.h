@@ -0,0 +1,26 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+
+// ====================================================================
+// LineFramer：按 '\n' 切分 TCP 字节流的重组缓冲区
+// 一次 recv 可能包含多条命令，也可能只有半条，统一在这里拼接/拆分
+// ====================================================================
+
+class LineFramer {
+public:
+    // 服务器端默认单帧上限 64 KB
+    explicit LineFramer(size_t maxFrame = 64 * 1024);
+
+    // 追加收到的字节，把完整的行 (已去掉 "\r\n") 追加到 frames
+    // 返回 false 表示有一帧 (完整的或未完成的) 超过上限，调用方应断开连接
+    bool feed(const char* data, size_t len, std::vector<std::string>& frames);
+
+    size_t buffered() const { return m_buf.size(); }
+    void clear();
+
+private:
+    std::string m_buf;
+    size_t m_scanPos = 0;   // 已确认不含 '\n' 的前缀长度，避免重复扫描
+    size_t m_maxFrame;
+};
@@ -0,0 +1,36 @@
+﻿#include "LogFeed.h"
+
+LogFeed::LogFeed(size_t capacity)
+    : m_ring(capacity > 0 ? capacity : 1)
+{
+}
+
+void LogFeed::push(std::string line) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ring[m_head].swap(line);
+    m_head = (m_head + 1) % m_ring.size();
+    if (m_count < m_ring.size()) {
+        m_count++;
+    }
+    else {
+        m_dropped++;
+        m_droppedTotal++;
+    }
+}
+
+void LogFeed::take(std::vector<std::string>& lines, unsigned long long& dropped) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t start = (m_head + m_ring.size() - m_count) % m_ring.size();
+    lines.reserve(lines.size() + m_count);
+    for (size_t i = 0; i < m_count; ++i) {
+        lines.push_back(std::move(m_ring[(start + i) % m_ring.size()]));
+    }
+    m_count = 0;
+    dropped = m_dropped;
+    m_dropped = 0;
+}
+
+unsigned long long LogFeed::droppedTotal() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_droppedTotal;
+}
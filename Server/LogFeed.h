@@ -0,0 +1,30 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+
+// ====================================================================
+// LogFeed：后台线程到界面的日志桥
+// 任意线程 push，界面线程按固定帧率 take 一整批，避免每行一个 Qt 信号
+// 固定容量的环形缓冲，界面来不及取时覆盖最旧的行并计数
+// ====================================================================
+
+class LogFeed {
+public:
+    explicit LogFeed(size_t capacity = 4096);
+
+    void push(std::string line);
+
+    // 取走当前缓冲的全部行 (按写入顺序)，dropped 返回自上次 take 以来被覆盖的行数
+    void take(std::vector<std::string>& lines, unsigned long long& dropped);
+
+    unsigned long long droppedTotal() const;
+
+private:
+    std::vector<std::string> m_ring;
+    size_t m_head = 0;      // 下一次写入的位置
+    size_t m_count = 0;
+    unsigned long long m_dropped = 0;
+    unsigned long long m_droppedTotal = 0;
+    mutable std::mutex m_mutex;
+};
@@ -0,0 +1,242 @@
+﻿#include "LogWriter.h"
+#include <ctime>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+LogWriter::LogWriter(const std::string& fileName)
+    : m_fileName(fileName)
+    , m_head(&m_stub)
+    , m_tail(&m_stub)
+{
+}
+
+LogWriter::~LogWriter() {
+    stop();
+    // stop 之后不会再有消费者，把未写出的节点释放掉 (只在 start 从未调用时发生)
+    while (Node* n = pop()) delete n;
+}
+
+void LogWriter::start() {
+    if (m_running) return;
+    m_running = true;
+    m_thread = std::thread(&LogWriter::threadLoop, this);
+}
+
+void LogWriter::stop() {
+    if (!m_running.exchange(false)) return;
+    m_wakeCv.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void LogWriter::setRotation(size_t maxBytes, int maxAgeSec, int keepFiles) {
+    m_maxBytes = maxBytes;
+    m_maxAgeSec = maxAgeSec;
+    m_keepFiles = keepFiles;
+}
+
+const char* LogWriter::levelName(Level level) {
+    switch (level) {
+    case LEVEL_DEBUG: return "debug";
+    case LEVEL_CHAT:  return "chat";
+    case LEVEL_INFO:  return "info";
+    case LEVEL_WARN:  return "warn";
+    case LEVEL_ERROR: return "error";
+    }
+    return "info";
+}
+
+bool LogWriter::parseLevel(const std::string& name, Level& level) {
+    for (int i = LEVEL_DEBUG; i <= LEVEL_ERROR; ++i) {
+        if (name == levelName((Level)i)) {
+            level = (Level)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ====================================================================
+// 生产者：一次原子交换完成入队
+// ====================================================================
+
+void LogWriter::write(Level level, std::string text) {
+    if (!isEnabled(level)) return;
+    if (m_pending.fetch_add(1, std::memory_order_relaxed) >= kMaxPending) {
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+        m_dropped++;
+        return;
+    }
+
+    Node* n = new Node();
+    n->level = level;
+    n->time = (long long)std::time(nullptr);
+    n->text = std::move(text);
+
+    Node* prev = m_head.exchange(n, std::memory_order_acq_rel);
+    prev->next.store(n, std::memory_order_release);
+}
+
+// 仅写线程调用；返回 nullptr 表示队列为空 (或某个生产者还没挂好 next)
+LogWriter::Node* LogWriter::pop() {
+    Node* tail = m_tail;
+    Node* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &m_stub) {
+        if (next == nullptr) return nullptr;
+        m_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+        m_tail = next;
+        return tail;
+    }
+    if (tail != m_head.load(std::memory_order_acquire)) return nullptr;
+
+    // 只剩最后一个节点：重新挂上 stub 才能把它取出来
+    m_stub.next.store(nullptr, std::memory_order_relaxed);
+    Node* prev = m_head.exchange(&m_stub, std::memory_order_acq_rel);
+    prev->next.store(&m_stub, std::memory_order_release);
+
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        m_tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+// ====================================================================
+// 写线程
+// ====================================================================
+
+void LogWriter::threadLoop() {
+    openFile();
+    std::string buf;
+
+    while (m_running) {
+        drain(buf);
+        if (m_pending.load(std::memory_order_relaxed) == 0) {
+            // 生产者不加锁也不通知，靠短超时轮询把延迟控制在 100ms 内
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wakeCv.wait_for(lock, std::chrono::milliseconds(100));
+        }
+    }
+    drain(buf);
+    m_file.close();
+}
+
+void LogWriter::drain(std::string& buf) {
+    std::vector<std::string> lines;
+    Node* n;
+    while ((n = pop()) != nullptr) {
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+
+        std::tm tstruct = {};
+        time_t t = (time_t)n->time;
+        localtime_s(&tstruct, &t);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tstruct);
+
+        std::string line = std::string("[") + stamp + "] [" + levelName(n->level) + "] " + n->text;
+        delete n;
+
+        buf += line;
+        buf += '\n';
+        lines.push_back(std::move(line));
+
+        if (buf.size() >= 64 * 1024) flushBuffer(buf);
+    }
+    flushBuffer(buf);
+
+    if (lines.empty()) {
+        // 空闲时也检查按时间滚动
+        if (m_fileBytes > 0 && (long long)std::time(nullptr) - m_fileOpenedAt >= m_maxAgeSec) rotate();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_tailMutex);
+    for (auto& l : lines) m_recent.push_back(std::move(l));
+    while (m_recent.size() > kTailLines) m_recent.pop_front();
+}
+
+void LogWriter::flushBuffer(std::string& buf) {
+    if (buf.empty()) return;
+    m_file.write(buf.data(), (std::streamsize)buf.size());
+    m_file.flush();
+    m_fileBytes += buf.size();
+    buf.clear();
+
+    if (m_fileBytes >= m_maxBytes || (long long)std::time(nullptr) - m_fileOpenedAt >= m_maxAgeSec) {
+        rotate();
+    }
+}
+
+std::vector<std::string> LogWriter::tail(size_t count) const {
+    std::lock_guard<std::mutex> lock(m_tailMutex);
+    count = std::min(count, m_recent.size());
+    return std::vector<std::string>(m_recent.end() - count, m_recent.end());
+}
+
+// ====================================================================
+// 文件与滚动
+// ====================================================================
+
+void LogWriter::openFile() {
+    m_file.open(m_fileName, std::ios::out | std::ios::app | std::ios::binary);
+    std::error_code ec;
+    uintmax_t size = fs::file_size(m_fileName, ec);
+    m_fileBytes = ec ? 0 : (size_t)size;
+    m_fileOpenedAt = (long long)std::time(nullptr);
+}
+
+void LogWriter::rotate() {
+    m_file.close();
+
+    std::tm tstruct = {};
+    time_t now = std::time(nullptr);
+    localtime_s(&tstruct, &now);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tstruct);
+
+    fs::path cur(m_fileName);
+    fs::path rotated = cur.parent_path() / (cur.stem().string() + "." + stamp + cur.extension().string());
+    std::error_code ec;
+    // 同一秒内多次滚动时追加序号，避免覆盖
+    for (int seq = 1; fs::exists(rotated, ec); ++seq) {
+        rotated = cur.parent_path() / (cur.stem().string() + "." + stamp + "-" + std::to_string(seq) + cur.extension().string());
+    }
+    fs::rename(cur, rotated, ec);
+
+    openFile();
+    pruneOldFiles();
+}
+
+// 只保留最近 m_keepFiles 个旧文件
+void LogWriter::pruneOldFiles() {
+    fs::path cur(m_fileName);
+    fs::path dir = cur.parent_path().empty() ? fs::path(".") : cur.parent_path();
+    std::string prefix = cur.stem().string() + ".";
+    std::string ext = cur.extension().string();
+
+    std::vector<std::pair<fs::file_time_type, fs::path>> old;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name == cur.filename().string()) continue;
+        if (name.size() > prefix.size() + ext.size()
+            && name.compare(0, prefix.size(), prefix) == 0
+            && name.compare(name.size() - ext.size(), ext.size(), ext) == 0) {
+            old.emplace_back(fs::last_write_time(entry.path(), ec), entry.path());
+        }
+    }
+    if ((int)old.size() <= m_keepFiles) return;
+
+    std::sort(old.begin(), old.end());
+    for (size_t i = 0; i + m_keepFiles < old.size(); ++i) {
+        fs::remove(old[i].second, ec);
+    }
+}
@@ -0,0 +1,96 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <condition_variable>
+
+// ====================================================================
+// LogWriter：后台异步日志
+// 任意线程调用 write() 只做一次无锁入队，格式化、写盘和滚动都在专用线程完成
+// ====================================================================
+
+class LogWriter {
+public:
+    // 级别从低到高；当前级别以下的日志直接丢弃
+    // LEVEL_CHAT 单独一档，设为 info 即可在热路径上关闭聊天内容记录
+    enum Level {
+        LEVEL_DEBUG = 0,
+        LEVEL_CHAT,
+        LEVEL_INFO,
+        LEVEL_WARN,
+        LEVEL_ERROR
+    };
+
+    // fileName 例如 "Log.txt"，滚动后的旧文件命名为 Log.20240101-120000.txt
+    explicit LogWriter(const std::string& fileName);
+    ~LogWriter();
+
+    void start();
+    void stop();    // 写完队列中剩余的日志后退出
+
+    // maxBytes：单个文件上限；maxAgeSec：单个文件最长使用时间；keepFiles：保留的旧文件个数
+    void setRotation(size_t maxBytes, int maxAgeSec, int keepFiles);
+    void setLevel(Level level) { m_level = level; }
+    Level level() const { return m_level; }
+    bool isEnabled(Level level) const { return level >= m_level.load(std::memory_order_relaxed); }
+
+    // 线程安全、不阻塞；队列积压超过上限时丢弃并计数
+    void write(Level level, std::string text);
+
+    // 最近写入的若干行 (内存中最多保留 kTailLines 行)
+    std::vector<std::string> tail(size_t count) const;
+    unsigned long long droppedCount() const { return m_dropped; }
+
+    static const char* levelName(Level level);
+    static bool parseLevel(const std::string& name, Level& level);
+
+private:
+    // 多生产者单消费者的无锁队列节点 (Vyukov 算法)
+    struct Node {
+        std::atomic<Node*> next{ nullptr };
+        Level level = LEVEL_INFO;
+        long long time = 0;
+        std::string text;
+    };
+
+    void threadLoop();
+    Node* pop();
+    void drain(std::string& buf);
+    void flushBuffer(std::string& buf);
+    void openFile();
+    void rotate();
+    void pruneOldFiles();
+
+    static constexpr size_t kTailLines = 1000;
+    static constexpr size_t kMaxPending = 100000;
+
+    std::string m_fileName;
+    std::atomic<Level> m_level{ LEVEL_INFO };
+
+    // 队列：生产者只交换 m_head，消费者独占 m_tail
+    std::atomic<Node*> m_head;
+    Node* m_tail;
+    Node m_stub;
+    std::atomic<size_t> m_pending{ 0 };
+    std::atomic<unsigned long long> m_dropped{ 0 };
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+    std::mutex m_wakeMutex;             // 只用于写线程空闲时的等待
+    std::condition_variable m_wakeCv;
+
+    // 以下仅写线程访问
+    std::ofstream m_file;
+    size_t m_fileBytes = 0;
+    long long m_fileOpenedAt = 0;
+    size_t m_maxBytes = 8 * 1024 * 1024;
+    int m_maxAgeSec = 24 * 3600;
+    int m_keepFiles = 10;
+
+    mutable std::mutex m_tailMutex;
+    std::deque<std::string> m_recent;
+};
@@ -0,0 +1,49 @@
+﻿#include "MessageId.h"
+#include <chrono>
+
+MessageIdGenerator::MessageIdGenerator(uint32_t nodeId)
+    : m_nodeId(nodeId & kMaxNode)
+{
+}
+
+long long MessageIdGenerator::nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() - kEpochMs;
+}
+
+MessageId MessageIdGenerator::next() {
+    uint64_t now = (uint64_t)nowMs() << kSeqBits;
+    uint64_t last = m_last.load(std::memory_order_relaxed);
+    uint64_t state;
+    do {
+        // 时钟回拨或同一毫秒内：在上一个值基础上加一
+        state = (now > last) ? now : last + 1;
+    } while (!m_last.compare_exchange_weak(last, state, std::memory_order_relaxed));
+
+    uint64_t ts = state >> kSeqBits;
+    uint64_t seq = state & kMaxSeq;
+    return (ts << (kNodeBits + kSeqBits)) | ((uint64_t)m_nodeId << kSeqBits) | seq;
+}
+
+void MessageIdGenerator::observe(MessageId id) {
+    uint64_t ts = id >> (kNodeBits + kSeqBits);
+    // 同一毫秒内节点号更大的 ID 比本节点任何序号都大，只能占满这一毫秒
+    uint64_t seq = (nodeOf(id) > m_nodeId) ? kMaxSeq : (id & kMaxSeq);
+    uint64_t state = (ts << kSeqBits) | seq;
+    uint64_t last = m_last.load(std::memory_order_relaxed);
+    while (state > last && !m_last.compare_exchange_weak(last, state, std::memory_order_relaxed)) {
+    }
+}
+
+bool MessageIdGenerator::parse(const std::string& text, MessageId& id) {
+    if (text.empty() || text.size() > 20) return false;
+    uint64_t value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        uint64_t digit = (uint64_t)(c - '0');
+        if (value > (UINT64_MAX - digit) / 10) return false;
+        value = value * 10 + digit;
+    }
+    id = value;
+    return true;
+}
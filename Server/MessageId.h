@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+// ====================================================================
+// MessageIdGenerator：64 位单调递增消息 ID
+// 布局 (高位到低位)：41 位毫秒时间戳 | 10 位节点号 | 12 位序号
+// 同一节点生成的 ID 严格递增，可直接作为排序键和历史记录游标
+// ====================================================================
+
+typedef uint64_t MessageId;
+
+class MessageIdGenerator {
+public:
+    static constexpr int kNodeBits = 10;
+    static constexpr int kSeqBits = 12;
+    static constexpr uint32_t kMaxNode = (1u << kNodeBits) - 1;
+    static constexpr uint32_t kMaxSeq = (1u << kSeqBits) - 1;
+    // 自定义纪元：2024-01-01 00:00:00 UTC，41 位毫秒约可用 69 年
+    static constexpr long long kEpochMs = 1704067200000LL;
+
+    explicit MessageIdGenerator(uint32_t nodeId = 1);
+
+    // 线程安全、无锁；同一毫秒内序号用尽时借用下一毫秒，保证不重复且不回退
+    MessageId next();
+
+    // 把状态抬到不低于 id，之后 next() 只会生成比它更大的 ID (启动时用已存储的最大 ID 调用)
+    void observe(MessageId id);
+
+    uint32_t getNodeId() const { return m_nodeId; }
+
+    // 协议和记录文件中以十进制字符串出现
+    static std::string toString(MessageId id) { return std::to_string(id); }
+    static bool parse(const std::string& text, MessageId& id);
+
+    // 按给定字段直接拼出 ID (用于导入旧记录，节点号 0 保留给导入)
+    static MessageId compose(long long timestampMs, uint32_t node, uint32_t seq) {
+        uint64_t ts = timestampMs > kEpochMs ? (uint64_t)(timestampMs - kEpochMs) : 0;
+        return (ts << (kNodeBits + kSeqBits)) | ((uint64_t)(node & kMaxNode) << kSeqBits) | (seq & kMaxSeq);
+    }
+
+    static long long timestampOf(MessageId id) { return (long long)(id >> (kNodeBits + kSeqBits)) + kEpochMs; }
+    static uint32_t nodeOf(MessageId id) { return (uint32_t)(id >> kSeqBits) & kMaxNode; }
+
+private:
+    static long long nowMs();
+
+    const uint32_t m_nodeId;
+    // (时间戳 << kSeqBits) | 序号，节点号在输出时再插入
+    std::atomic<uint64_t> m_last{ 0 };
+};
@@ -0,0 +1,409 @@
+﻿#include "NetEngine.h"
+#include "LineFramer.h"
+#include <algorithm>
+#include <chrono>
+
+// 单个连接的引擎侧状态
+struct NetEngine::Connection {
+    SOCKET sock = INVALID_SOCKET;       // 关闭后在 outMutex 内置为 INVALID_SOCKET
+    Worker* owner = nullptr;
+    LineFramer framer;                  // 仅所属 I/O 线程访问
+
+    std::mutex outMutex;                // 保护以下发送队列字段
+    std::deque<Buffer> outQueue;
+    size_t outOffset = 0;               // 队首缓冲已写出的字节数
+    size_t peakBytes = 0;
+    unsigned long long dropped = 0;
+    bool slow = false;
+    std::atomic<size_t> outBytes{ 0 };  // 尚未写出的字节数，I/O 线程据此决定是否关注 POLLWRNORM
+
+    std::atomic<bool> closing{ false };
+    std::atomic<long long> closeDeadline{ 0 };
+};
+
+NetEngine::NetEngine(Handler* handler)
+    : m_handler(handler)
+    , m_running(false)
+{
+}
+
+NetEngine::~NetEngine() {
+    stop();
+}
+
+long long NetEngine::nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 用一对自连接的 UDP socket 充当 WSAPoll 的唤醒通道 (Windows 没有 eventfd)
+bool NetEngine::createWakePair(SOCKET& recvSock, SOCKET& sendSock) {
+    recvSock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sendSock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (recvSock == INVALID_SOCKET || sendSock == INVALID_SOCKET) return false;
+
+    SOCKADDR_IN addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (::bind(recvSock, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) return false;
+
+    int len = sizeof(addr);
+    if (getsockname(recvSock, (sockaddr*)&addr, &len) == SOCKET_ERROR) return false;
+    if (connect(sendSock, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) return false;
+
+    u_long nonBlocking = 1;
+    ioctlsocket(recvSock, FIONBIO, &nonBlocking);
+    ioctlsocket(sendSock, FIONBIO, &nonBlocking);
+    return true;
+}
+
+bool NetEngine::start(int ioThreads) {
+    if (m_running) return true;
+
+    if (ioThreads <= 0) {
+        ioThreads = (int)std::thread::hardware_concurrency();
+        ioThreads = std::max(2, std::min(ioThreads, 8));
+    }
+
+    m_running = true;
+    for (int i = 0; i < ioThreads; ++i) {
+        auto w = std::make_unique<Worker>();
+        if (!createWakePair(w->wakeRecv, w->wakeSend)) {
+            if (w->wakeRecv != INVALID_SOCKET) closesocket(w->wakeRecv);
+            if (w->wakeSend != INVALID_SOCKET) closesocket(w->wakeSend);
+            stop();
+            return false;
+        }
+        w->fds.push_back({ w->wakeRecv, POLLRDNORM, 0 });
+        w->conns.push_back(nullptr);
+        m_workers.push_back(std::move(w));
+    }
+    for (auto& w : m_workers) {
+        Worker* raw = w.get();
+        w->thread = std::thread([this, raw]() { workerLoop(raw); });
+    }
+    return true;
+}
+
+void NetEngine::stop() {
+    if (!m_running && m_workers.empty()) return;
+    m_running = false;
+
+    for (auto& w : m_workers) wake(w.get());
+    for (auto& w : m_workers) {
+        if (w->thread.joinable()) w->thread.join();
+        for (size_t i = 1; i < w->fds.size(); ++i) closesocket(w->fds[i].fd);
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            for (auto& conn : w->pendingAdd) closesocket(conn->sock);
+        }
+        closesocket(w->wakeRecv);
+        closesocket(w->wakeSend);
+    }
+    m_workers.clear();
+
+    std::lock_guard<std::mutex> lock(m_connMutex);
+    m_conns.clear();
+}
+
+void NetEngine::setWatermarks(size_t low, size_t high, size_t hardLimit) {
+    m_lowWatermark = low;
+    m_highWatermark = high;
+    m_hardLimit = hardLimit;
+}
+
+bool NetEngine::addConnection(SOCKET s) {
+    if (!m_running || m_workers.empty()) return false;
+
+    Worker* target = m_workers[0].get();
+    for (auto& w : m_workers) {
+        if (w->count < target->count) target = w.get();
+    }
+
+    // 所有读写都走就绪通知，socket 必须是非阻塞的
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+
+    auto conn = std::make_shared<Connection>();
+    conn->sock = s;
+    conn->owner = target;
+    {
+        std::lock_guard<std::mutex> lock(m_connMutex);
+        m_conns[s] = conn;
+    }
+    target->count++;
+    {
+        std::lock_guard<std::mutex> lock(target->mutex);
+        target->pendingAdd.push_back(conn);
+    }
+    wake(target);
+    return true;
+}
+
+NetEngine::ConnectionPtr NetEngine::getConnection(SOCKET s) const {
+    std::lock_guard<std::mutex> lock(m_connMutex);
+    auto it = m_conns.find(s);
+    if (it == m_conns.end()) return nullptr;
+    return it->second;
+}
+
+void NetEngine::closeConnection(SOCKET s, bool flushFirst) {
+    closeConnection(getConnection(s), flushFirst);
+}
+
+void NetEngine::closeConnection(const ConnectionPtr& conn, bool flushFirst) {
+    if (!conn) return;
+
+    conn->closeDeadline = flushFirst ? nowMs() + 5000 : 0;
+    conn->closing = true;
+    wake(conn->owner);
+}
+
+bool NetEngine::send(SOCKET s, const std::string& data, SendPolicy policy) {
+    return send(s, makeBuffer(data), policy);
+}
+
+bool NetEngine::send(SOCKET s, const Buffer& data, SendPolicy policy) {
+    if (!data || data->empty()) return true;
+    return send(getConnection(s), data, policy);
+}
+
+bool NetEngine::send(const ConnectionPtr& conn, const Buffer& data, SendPolicy policy) {
+    if (!data || data->empty()) return true;
+    if (!conn || conn->closing) return false;
+
+    bool needWake = false;
+    bool overflow = false;
+    {
+        std::lock_guard<std::mutex> lock(conn->outMutex);
+        // 加锁后再查一次：dropConnection 可能已在两次检查之间关闭句柄，
+        // 句柄值随后可能被 accept 分给新连接，不能再往上写
+        if (conn->closing || conn->sock == INVALID_SOCKET) return false;
+        SOCKET s = conn->sock;
+        if (policy == SEND_DROPPABLE && conn->slow) {
+            conn->dropped++;
+            m_droppedMessages++;
+            return false;
+        }
+
+        size_t offset = 0;
+        if (conn->outQueue.empty()) {
+            // 快速路径：队列为空时直接写，大多数消息到这里就结束了
+            int n = ::send(s, data->data(), (int)data->size(), 0);
+            if (n > 0) offset = (size_t)n;
+            else if (WSAGetLastError() != WSAEWOULDBLOCK) return false; // 连接已坏，交给 I/O 线程回收
+            if (offset == data->size()) return true;
+            needWake = true;   // 需要 I/O 线程开始关注可写事件
+            conn->outOffset = offset;
+        }
+        conn->outQueue.push_back(data);
+
+        size_t queued = conn->outBytes + (data->size() - offset);
+        conn->outBytes = queued;
+        if (queued > conn->peakBytes) conn->peakBytes = queued;
+        if (queued > m_highWatermark) conn->slow = true;
+        if (queued > m_hardLimit) overflow = true;
+    }
+
+    if (overflow) {
+        // 积压过多：对端长期不读，直接断开，不再尝试发完
+        m_slowDisconnects++;
+        closeConnection(conn, false);
+        return false;
+    }
+    if (needWake) wake(conn->owner);
+    return true;
+}
+
+size_t NetEngine::connectionCount() const {
+    size_t total = 0;
+    for (const auto& w : m_workers) total += w->count;
+    return total;
+}
+
+NetEngine::QueueStat NetEngine::queueStat(const ConnectionPtr& conn) const {
+    if (!conn) return { INVALID_SOCKET, 0, 0, 0, false };
+    std::lock_guard<std::mutex> lock(conn->outMutex);
+    return { conn->sock, conn->outBytes, conn->peakBytes, conn->dropped, conn->slow };
+}
+
+std::vector<NetEngine::QueueStat> NetEngine::queueStats() const {
+    std::vector<std::shared_ptr<Connection>> conns;
+    {
+        std::lock_guard<std::mutex> lock(m_connMutex);
+        conns.reserve(m_conns.size());
+        for (const auto& pair : m_conns) conns.push_back(pair.second);
+    }
+
+    std::vector<QueueStat> stats;
+    stats.reserve(conns.size());
+    for (const auto& conn : conns) {
+        std::lock_guard<std::mutex> lock(conn->outMutex);
+        stats.push_back({ conn->sock, conn->outBytes, conn->peakBytes, conn->dropped, conn->slow });
+    }
+    return stats;
+}
+
+void NetEngine::wake(Worker* w) {
+    char b = 1;
+    ::send(w->wakeSend, &b, 1, 0);
+}
+
+// 先回调再 closesocket，避免句柄被新连接复用时串到旧连接的状态上
+void NetEngine::dropConnection(Worker* w, size_t index) {
+    std::shared_ptr<Connection> conn = w->conns[index];
+    SOCKET s = conn->sock;
+    w->fds[index] = w->fds.back();
+    w->fds.pop_back();
+    w->conns[index] = w->conns.back();
+    w->conns.pop_back();
+
+    conn->closing = true;
+    m_handler->onDisconnect(s);
+    {
+        std::lock_guard<std::mutex> lock(m_connMutex);
+        m_conns.erase(s);
+    }
+    w->count--;
+    {
+        // 释放积压的缓冲并在锁内关闭句柄，其它线程此后的 send 加锁后会看到 INVALID_SOCKET
+        std::lock_guard<std::mutex> lock(conn->outMutex);
+        conn->outQueue.clear();
+        conn->outBytes = 0;
+        conn->sock = INVALID_SOCKET;
+        closesocket(s);
+    }
+}
+
+// 读一次并把完整的帧依次交给 Handler；返回 false 表示需要断开
+bool NetEngine::readConnection(Connection& conn, char* buf, int bufSize) {
+    int len = recv(conn.sock, buf, bufSize, 0);
+    if (len == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK) return true;
+    if (len <= 0) return false;
+
+    std::vector<std::string> frames;
+    bool ok = conn.framer.feed(buf, (size_t)len, frames);
+    for (const auto& frame : frames) {
+        if (conn.closing) break;   // 已被踢出/登录失败的连接不再处理后续命令
+        m_handler->onFrame(conn.sock, frame);
+    }
+    return ok;
+}
+
+// 把队列里的多个缓冲合并成一次 WSASend；返回 false 表示连接出错
+bool NetEngine::flushConnection(Connection& conn) {
+    const DWORD kMaxBufs = 64;
+    std::lock_guard<std::mutex> lock(conn.outMutex);
+    if (conn.sock == INVALID_SOCKET) return false;
+
+    while (!conn.outQueue.empty()) {
+        WSABUF bufs[kMaxBufs];
+        DWORD count = 0;
+        size_t requested = 0;
+        size_t offset = conn.outOffset;
+        for (auto it = conn.outQueue.begin(); it != conn.outQueue.end() && count < kMaxBufs; ++it) {
+            bufs[count].buf = const_cast<char*>((*it)->data()) + offset;
+            bufs[count].len = (unsigned long)((*it)->size() - offset);
+            requested += bufs[count].len;
+            offset = 0;
+            count++;
+        }
+
+        DWORD sent = 0;
+        if (WSASend(conn.sock, bufs, count, &sent, 0, NULL, NULL) == SOCKET_ERROR) {
+            if (WSAGetLastError() == WSAEWOULDBLOCK) break;
+            return false;
+        }
+
+        conn.outBytes -= sent;
+        size_t remaining = sent;
+        while (remaining > 0) {
+            size_t avail = conn.outQueue.front()->size() - conn.outOffset;
+            if (remaining >= avail) {
+                remaining -= avail;
+                conn.outQueue.pop_front();
+                conn.outOffset = 0;
+            }
+            else {
+                conn.outOffset += remaining;
+                remaining = 0;
+            }
+        }
+        if (sent < requested) break;   // 内核发送缓冲已满，等下一次可写
+    }
+
+    if (conn.outBytes < m_lowWatermark) conn.slow = false;
+    return true;
+}
+
+void NetEngine::workerLoop(Worker* w) {
+    // 每个 I/O 线程只有一块接收缓冲区，内存不随连接数增长
+    std::vector<char> buf(64 * 1024);
+
+    while (m_running) {
+        // 按队列状态决定是否关注可写；顺便回收已发完 (或超时) 的待关闭连接
+        bool lingering = false;
+        long long now = nowMs();
+        for (size_t i = 1; i < w->fds.size();) {
+            Connection& conn = *w->conns[i];
+            bool pending = conn.outBytes > 0;
+            if (conn.closing) {
+                if (!pending || now >= conn.closeDeadline) {
+                    dropConnection(w, i);
+                    continue;
+                }
+                lingering = true;
+            }
+            w->fds[i].events = pending ? (POLLRDNORM | POLLWRNORM) : POLLRDNORM;
+            ++i;
+        }
+
+        int n = WSAPoll(w->fds.data(), (unsigned long)w->fds.size(), lingering ? 1000 : -1);
+        if (!m_running) break;
+        if (n == SOCKET_ERROR) continue;
+
+        if (w->fds[0].revents) {
+            char drain[64];
+            while (recv(w->wakeRecv, drain, sizeof(drain), 0) > 0) {}
+            w->fds[0].revents = 0;
+        }
+
+        std::vector<std::shared_ptr<Connection>> adds;
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            adds.swap(w->pendingAdd);
+        }
+
+        for (auto& conn : adds) {
+            w->fds.push_back({ conn->sock, POLLRDNORM, 0 });
+            w->conns.push_back(conn);
+            m_handler->onConnect(conn->sock);
+        }
+
+        for (size_t i = 1; i < w->fds.size();) {
+            short events = w->fds[i].revents;
+            w->fds[i].revents = 0;
+
+            bool drop = false;
+            if (events & POLLRDNORM) {
+                drop = !readConnection(*w->conns[i], buf.data(), (int)buf.size());
+            }
+            if (!drop && (events & POLLWRNORM)) {
+                drop = !flushConnection(*w->conns[i]);
+            }
+            if (!drop && (events & (POLLERR | POLLNVAL))) {
+                drop = true;
+            }
+            if (!drop && (events & POLLHUP) && !(events & POLLRDNORM)) {
+                drop = true;
+            }
+
+            if (drop) {
+                dropConnection(w, i); // 末尾元素被换到 i，下一轮继续检查 i
+                continue;
+            }
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+﻿#pragma once
+#include <winsock2.h>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+// ====================================================================
+// NetEngine：基于 WSAPoll 就绪通知的连接引擎
+// 少量固定的 I/O 线程持有全部客户端 socket，取代“一连接一线程”
+// ====================================================================
+
+class NetEngine {
+public:
+    // 事件回调：同一个 socket 的回调总是在它所属的 I/O 线程里串行执行
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+        virtual void onConnect(SOCKET s) = 0;
+        // 每次回调一条完整的命令行 (不含换行符)
+        virtual void onFrame(SOCKET s, const std::string& frame) = 0;
+        virtual void onDisconnect(SOCKET s) = 0;
+    };
+
+    // 发送策略：广播类消息在对端积压时可以丢弃，直接应答不丢
+    enum SendPolicy {
+        SEND_RELIABLE,
+        SEND_DROPPABLE
+    };
+
+    // 共享的只读发送缓冲，群发时所有接收者引用同一份数据
+    typedef std::shared_ptr<const std::string> Buffer;
+    static Buffer makeBuffer(std::string data) { return std::make_shared<const std::string>(std::move(data)); }
+
+    // 每个连接的发送队列快照，用于 /queues 观察慢消费者
+    struct QueueStat {
+        SOCKET sock;
+        size_t queuedBytes;
+        size_t peakBytes;
+        unsigned long long dropped;
+        bool slow;
+    };
+
+    // 连接句柄：会话层持有它即可直接发送，省去每次按 socket 查表
+    // 具体结构只在 NetEngine.cpp 中定义，外部只当作不透明指针
+    struct Connection;
+    typedef std::shared_ptr<Connection> ConnectionPtr;
+
+    explicit NetEngine(Handler* handler);
+    ~NetEngine();
+
+    // ioThreads <= 0 时按 CPU 核数自动决定
+    bool start(int ioThreads = 0);
+    void stop();
+
+    // 积压超过 high 后进入慢消费者状态 (丢弃 SEND_DROPPABLE)，回落到 low 以下恢复；
+    // 超过 hardLimit 直接断开
+    void setWatermarks(size_t low, size_t high, size_t hardLimit);
+
+    // 把 accept 得到的 socket 交给连接数最少的 I/O 线程
+    bool addConnection(SOCKET s);
+    // 线程安全的关闭请求：flushFirst 时先尽量发完队列 (最多等 5 秒)，
+    // 真正的 closesocket 和 onDisconnect 由所属 I/O 线程完成
+    void closeConnection(SOCKET s, bool flushFirst = true);
+    void closeConnection(const ConnectionPtr& conn, bool flushFirst = true);
+
+    // 线程安全、不阻塞：队列为空时直接尝试写，写不完的部分排队由 I/O 线程异步发出
+    bool send(SOCKET s, const std::string& data, SendPolicy policy = SEND_RELIABLE);
+    bool send(SOCKET s, const Buffer& data, SendPolicy policy = SEND_RELIABLE);
+    bool send(const ConnectionPtr& conn, const Buffer& data, SendPolicy policy = SEND_RELIABLE);
+
+    // addConnection 之后到连接被回收之前都能取到；连接关闭后句柄仍可安全持有，发送会直接失败
+    ConnectionPtr getConnection(SOCKET s) const;
+    QueueStat queueStat(const ConnectionPtr& conn) const;
+
+    size_t connectionCount() const;
+    int ioThreadCount() const { return (int)m_workers.size(); }
+    std::vector<QueueStat> queueStats() const;
+    unsigned long long droppedMessages() const { return m_droppedMessages; }
+    unsigned long long slowDisconnects() const { return m_slowDisconnects; }
+
+private:
+    struct Worker {
+        std::thread thread;
+        SOCKET wakeRecv = INVALID_SOCKET;   // 自连接的 UDP socket，用于唤醒 WSAPoll
+        SOCKET wakeSend = INVALID_SOCKET;
+        std::mutex mutex;                   // 保护 pendingAdd
+        std::vector<std::shared_ptr<Connection>> pendingAdd;
+        std::vector<WSAPOLLFD> fds;         // 仅 I/O 线程自己访问，fds[0] 固定为 wakeRecv
+        std::vector<std::shared_ptr<Connection>> conns; // 与 fds 一一对应，conns[0] 为空
+        std::atomic<size_t> count{ 0 };
+    };
+
+    void workerLoop(Worker* w);
+    void wake(Worker* w);
+    void dropConnection(Worker* w, size_t index);
+    bool readConnection(Connection& conn, char* buf, int bufSize);
+    bool flushConnection(Connection& conn);
+    static bool createWakePair(SOCKET& recvSock, SOCKET& sendSock);
+    static long long nowMs();
+
+    Handler* m_handler;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<bool> m_running;
+
+    std::map<SOCKET, std::shared_ptr<Connection>> m_conns;
+    mutable std::mutex m_connMutex;
+
+    size_t m_lowWatermark = 64 * 1024;
+    size_t m_highWatermark = 256 * 1024;
+    size_t m_hardLimit = 4 * 1024 * 1024;
+    std::atomic<unsigned long long> m_droppedMessages{ 0 };
+    std::atomic<unsigned long long> m_slowDisconnects{ 0 };
+};
@@ -0,0 +1,162 @@
+﻿#include "RequestStore.h"
+#include "JournalReader.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string formatRequest(const PendingRequest& req) {
+    return req.type + "|" + std::to_string(req.fromId) + "|" + req.fromName + "|" + std::to_string(req.targetId) + "\n";
+}
+
+}
+
+RequestStore::RequestStore(FileHandleCache& files, const std::string& fileName)
+    : m_files(files)
+    , m_fileName(fileName)
+{
+}
+
+RequestStore::RequestIndex* RequestStore::indexFor(const std::string& type) {
+    if (type == "FRIEND") return &m_byUser;
+    if (type == "GROUP") return &m_byGroup;
+    return nullptr;
+}
+
+bool RequestStore::load() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_byUser.clear();
+    m_byGroup.clear();
+    m_pending = 0;
+    m_logLines = 0;
+
+    // 缓存的追加句柄会妨碍截掉写了一半的末行
+    m_files.close(m_fileName, false);
+    m_logLines = readJournalLines(m_fileName, [this](const std::string& line) {
+        std::vector<std::string> parts;
+        std::stringstream ss(line);
+        std::string part;
+        while (std::getline(ss, part, '|')) parts.push_back(part);
+        if (parts.size() != 4) return;
+
+        if (parts[0] == "DEL") {
+            eraseLocked(parts[1], atoi(parts[2].c_str()), atoi(parts[3].c_str()));
+        }
+        else {
+            PendingRequest req;
+            req.type = parts[0];
+            req.fromId = atoi(parts[1].c_str());
+            req.fromName = parts[2];
+            req.targetId = atoi(parts[3].c_str());
+            if (req.fromId > 0 && req.targetId > 0) insertLocked(req);
+        }
+    });
+    std::cout << ">> Loaded " << m_pending << " pending requests (" << m_logLines << " log lines)." << std::endl;
+    if (m_logLines >= kCompactMin && m_logLines > 2 * m_pending) compactLocked();
+    return true;
+}
+
+// 调用方需已持有 m_mutex
+bool RequestStore::insertLocked(const PendingRequest& req) {
+    RequestIndex* index = indexFor(req.type);
+    if (!index) return false;
+    std::vector<PendingRequest>& list = (*index)[req.targetId];
+    for (const PendingRequest& r : list) {
+        if (r.fromId == req.fromId) return false;
+    }
+    list.push_back(req);
+    m_pending++;
+    return true;
+}
+
+// 调用方需已持有 m_mutex
+bool RequestStore::eraseLocked(const std::string& type, int fromId, int targetId) {
+    RequestIndex* index = indexFor(type);
+    if (!index) return false;
+    auto it = index->find(targetId);
+    if (it == index->end()) return false;
+    std::vector<PendingRequest>& list = it->second;
+    auto r = std::find_if(list.begin(), list.end(), [fromId](const PendingRequest& p) { return p.fromId == fromId; });
+    if (r == list.end()) return false;
+    list.erase(r);
+    if (list.empty()) index->erase(it);
+    m_pending--;
+    return true;
+}
+
+// 调用方需已持有 m_mutex
+bool RequestStore::appendLocked(const std::string& line) {
+    FileHandlePtr file = m_files.acquire(m_fileName, "ab");
+    if (!file) return false;
+    return file->write(line.data(), line.size()) && file->flush();
+}
+
+// 调用方需已持有 m_mutex；先写临时文件再改名
+bool RequestStore::compactLocked() {
+    std::string tmp = m_fileName + ".tmp";
+    size_t lines = 0;
+    {
+        std::ofstream ofs(tmp, std::ios::out | std::ios::trunc | std::ios::binary);
+        for (const RequestIndex* index : { &m_byUser, &m_byGroup }) {
+            for (const auto& pair : *index) {
+                for (const PendingRequest& req : pair.second) {
+                    ofs << formatRequest(req);
+                    lines++;
+                }
+            }
+        }
+        if (!ofs.good()) return false;
+    }
+    // 缓存里的追加句柄指向旧文件
+    m_files.close(m_fileName, false);
+    std::error_code ec;
+    fs::rename(tmp, m_fileName, ec);
+    if (ec) return false;
+    m_logLines = lines;
+    return true;
+}
+
+bool RequestStore::add(const PendingRequest& req) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!insertLocked(req)) return false;
+    m_logLines++;
+    if (!appendLocked(formatRequest(req))) {
+        std::cout << "[Error] Failed to persist request " << req.type << " " << req.fromId << " -> " << req.targetId << std::endl;
+    }
+    return true;
+}
+
+bool RequestStore::remove(const std::string& type, int fromId, int targetId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!eraseLocked(type, fromId, targetId)) return false;
+    m_logLines++;
+    appendLocked("DEL|" + type + "|" + std::to_string(fromId) + "|" + std::to_string(targetId) + "\n");
+    // 日志中作废的行超过一半时重写，摊还到每次处理为 O(1)
+    if (m_logLines >= kCompactMin && m_logLines > 2 * m_pending) compactLocked();
+    return true;
+}
+
+std::vector<PendingRequest> RequestStore::getForUser(int userId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_byUser.find(userId);
+    if (it == m_byUser.end()) return {};
+    return it->second;
+}
+
+std::vector<PendingRequest> RequestStore::getForGroup(int groupId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_byGroup.find(groupId);
+    if (it == m_byGroup.end()) return {};
+    return it->second;
+}
+
+size_t RequestStore::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending;
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include "FileHandleCache.h"
+
+// ====================================================================
+// RequestStore：待处理的好友/入群申请
+// 内存中按目标用户 (FRIEND) 和目标群 (GROUP) 建索引，列出、处理一条申请只涉及该用户/该群的申请
+// 持久化为追加日志 Request.txt：
+//   FRIEND|申请人ID|申请人名|目标用户ID     新申请 (与旧格式相同)
+//   GROUP|申请人ID|申请人名|群ID
+//   DEL|类型|申请人ID|目标ID               已处理
+// 日志行数远超待处理数时重写为只含待处理申请的快照
+// ====================================================================
+
+struct PendingRequest {
+    std::string type;       // "FRIEND" 或 "GROUP"
+    int fromId = 0;
+    std::string fromName;
+    int targetId = 0;       // 好友申请为用户 ID，入群申请为群 ID
+};
+
+class RequestStore {
+public:
+    RequestStore(FileHandleCache& files, const std::string& fileName = "Request.txt");
+
+    bool load();
+
+    // 同一申请 (类型、申请人、目标) 已存在时返回 false
+    bool add(const PendingRequest& req);
+    // 不存在时返回 false
+    bool remove(const std::string& type, int fromId, int targetId);
+
+    // 发给某个用户的好友申请 / 某个群的入群申请，按提交顺序
+    std::vector<PendingRequest> getForUser(int userId) const;
+    std::vector<PendingRequest> getForGroup(int groupId) const;
+
+    size_t getPendingCount() const;
+
+    static constexpr size_t kCompactMin = 1024;
+
+private:
+    typedef std::unordered_map<int, std::vector<PendingRequest>> RequestIndex;
+
+    RequestIndex* indexFor(const std::string& type);
+    bool insertLocked(const PendingRequest& req);
+    bool eraseLocked(const std::string& type, int fromId, int targetId);
+    bool appendLocked(const std::string& line);
+    bool compactLocked();
+
+    FileHandleCache& m_files;
+    std::string m_fileName;
+
+    RequestIndex m_byUser;      // FRIEND：目标用户 -> 申请
+    RequestIndex m_byGroup;     // GROUP：目标群 -> 申请
+    size_t m_pending = 0;
+    size_t m_logLines = 0;      // 日志文件中的行数
+    mutable std::mutex m_mutex;
+};
@@ -0,0 +1,73 @@
+﻿#include "RosterCache.h"
+
+RosterCache::RosterCache(size_t capacity)
+    : m_capacity(capacity > 0 ? capacity : 1)
+{
+}
+
+NetEngine::Buffer RosterCache::find(int gid, uint64_t version) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(gid);
+    if (it == m_entries.end() || it->second.version != version) {
+        m_misses++;
+        return nullptr;
+    }
+    m_hits++;
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+    return it->second.packet;
+}
+
+NetEngine::Buffer RosterCache::store(int gid, uint64_t version, uint64_t presenceEpoch, std::string packet,
+    std::vector<std::pair<std::string, size_t>> statusOffsets)
+{
+    NetEngine::Buffer buffer = NetEngine::makeBuffer(std::move(packet));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (presenceEpoch != m_presenceEpoch) return buffer;
+
+    auto it = m_entries.find(gid);
+    if (it == m_entries.end()) {
+        if (m_entries.size() >= m_capacity) {
+            m_entries.erase(m_lru.back());
+            m_lru.pop_back();
+        }
+        m_lru.push_front(gid);
+        it = m_entries.emplace(gid, Entry()).first;
+        it->second.lruPos = m_lru.begin();
+    }
+    else {
+        // 并发构建时保留较新的版本
+        if (it->second.version > version) return buffer;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+    }
+
+    Entry& e = it->second;
+    e.version = version;
+    e.packet = buffer;
+    e.statusOffsets.clear();
+    e.statusOffsets.reserve(statusOffsets.size());
+    for (auto& so : statusOffsets) e.statusOffsets.emplace(std::move(so.first), so.second);
+    return buffer;
+}
+
+void RosterCache::setPresence(const std::string& username, const std::function<bool()>& isOnline, const std::vector<int>& gids) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_presenceEpoch++;
+    const char bit = isOnline() ? '1' : '0';
+    for (int gid : gids) {
+        auto it = m_entries.find(gid);
+        if (it == m_entries.end()) continue;
+        Entry& e = it->second;
+        auto pos = e.statusOffsets.find(username);
+        if (pos == e.statusOffsets.end() || (*e.packet)[pos->second] == bit) continue;
+
+        std::string patched = *e.packet;
+        patched[pos->second] = bit;
+        e.packet = NetEngine::makeBuffer(std::move(patched));
+        m_patches++;
+    }
+}
+
+size_t RosterCache::getGroupCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
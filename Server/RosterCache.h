@@ -0,0 +1,59 @@
+﻿#pragma once
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include "NetEngine.h"
+
+// ====================================================================
+// RosterCache：已序列化的 CMD:GROUP_MEMBERS 包，按群缓存
+// 以群版本号 (成员/权限变化时递增) 判断是否过期；上线/下线不重建，
+// 只在已缓存的包里改写该成员的在线位 (复制一份再改，已发出的包不受影响)
+// 同一个 Buffer 直接发给所有查看者
+// ====================================================================
+
+class RosterCache {
+public:
+    explicit RosterCache(size_t capacity = 4096);
+
+    // 缓存的版本与 version 一致时返回，否则返回空
+    NetEngine::Buffer find(int gid, uint64_t version);
+
+    // 构建前先取在线状态纪元；构建期间有人上线/下线时只返回、不缓存，避免存入过期的在线位
+    uint64_t getPresenceEpoch() const { return m_presenceEpoch; }
+    // statusOffsets：每个成员的在线位 ('0'/'1') 在 packet 中的下标
+    NetEngine::Buffer store(int gid, uint64_t version, uint64_t presenceEpoch, std::string packet,
+        std::vector<std::pair<std::string, size_t>> statusOffsets);
+
+    // 用户上线/下线：gids 为该用户所在的群
+    // isOnline 在缓存锁内求值：断线与重连并发时，后执行的一次总是读到最新状态，不会被先算好的旧值覆盖
+    void setPresence(const std::string& username, const std::function<bool()>& isOnline, const std::vector<int>& gids);
+
+    uint64_t getHits() const { return m_hits; }
+    uint64_t getMisses() const { return m_misses; }
+    uint64_t getPatches() const { return m_patches; }
+    size_t getGroupCount() const;
+
+private:
+    struct Entry {
+        uint64_t version = 0;
+        NetEngine::Buffer packet;
+        std::unordered_map<std::string, size_t> statusOffsets;
+        std::list<int>::iterator lruPos;
+    };
+
+    const size_t m_capacity;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<int, Entry> m_entries;
+    std::list<int> m_lru;   // 前面是最近使用的
+    std::atomic<uint64_t> m_presenceEpoch{ 0 };
+
+    std::atomic<uint64_t> m_hits{ 0 };
+    std::atomic<uint64_t> m_misses{ 0 };
+    std::atomic<uint64_t> m_patches{ 0 };
+};
@@ -0,0 +1,57 @@
+﻿#include "SeqBitmap.h"
+#include <algorithm>
+
+void SeqBitmap::add(uint64_t seq) {
+    Block& block = m_blocks[seq >> 16];
+    uint16_t low = (uint16_t)(seq & 0xFFFF);
+
+    if (!block.bits.empty()) {
+        uint64_t& word = block.bits[low >> 6];
+        uint64_t mask = 1ULL << (low & 63);
+        if (word & mask) return;
+        word |= mask;
+        m_count++;
+        return;
+    }
+
+    auto it = std::lower_bound(block.array.begin(), block.array.end(), low);
+    if (it != block.array.end() && *it == low) return;
+    block.array.insert(it, low);
+    m_count++;
+
+    if (block.array.size() > kArrayMax) {
+        block.bits.assign(65536 / 64, 0);
+        for (uint16_t v : block.array) block.bits[v >> 6] |= 1ULL << (v & 63);
+        std::vector<uint16_t>().swap(block.array);
+    }
+}
+
+bool SeqBitmap::contains(uint64_t seq) const {
+    auto it = m_blocks.find(seq >> 16);
+    if (it == m_blocks.end()) return false;
+    uint16_t low = (uint16_t)(seq & 0xFFFF);
+    const Block& block = it->second;
+    if (!block.bits.empty()) return (block.bits[low >> 6] >> (low & 63)) & 1;
+    return std::binary_search(block.array.begin(), block.array.end(), low);
+}
+
+std::vector<uint64_t> SeqBitmap::toVector() const {
+    std::vector<uint64_t> out;
+    out.reserve((size_t)m_count);
+    for (const auto& pair : m_blocks) {
+        uint64_t base = pair.first << 16;
+        const Block& block = pair.second;
+        if (!block.bits.empty()) {
+            for (size_t w = 0; w < block.bits.size(); ++w) {
+                uint64_t word = block.bits[w];
+                for (int b = 0; word != 0 && b < 64; ++b, word >>= 1) {
+                    if (word & 1) out.push_back(base + w * 64 + b);
+                }
+            }
+        }
+        else {
+            for (uint16_t v : block.array) out.push_back(base + v);
+        }
+    }
+    return out;
+}
@@ -0,0 +1,33 @@
+﻿#pragma once
+#include <map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// ====================================================================
+// SeqBitmap：按序号存放的压缩位图 (Roaring 的简化版)
+// 序号按高位分块，每块 65536 个；稀疏块用有序 uint16 数组，
+// 超过 kArrayMax 个后转成定长位图，查询都是一次 map 查找加一次探测
+// ====================================================================
+
+class SeqBitmap {
+public:
+    void add(uint64_t seq);
+    bool contains(uint64_t seq) const;
+    bool empty() const { return m_blocks.empty(); }
+    uint64_t cardinality() const { return m_count; }
+
+    // 升序输出全部序号 (用于持久化)
+    std::vector<uint64_t> toVector() const;
+
+    static constexpr size_t kArrayMax = 4096;
+
+private:
+    struct Block {
+        std::vector<uint16_t> array;    // 稀疏时使用，升序
+        std::vector<uint64_t> bits;     // 稠密时使用，1024 个字
+    };
+
+    std::map<uint64_t, Block> m_blocks;
+    uint64_t m_count = 0;
+};
@@ -6,6 +6,7 @@
 #include <ctime>   
 #include <iomanip>
 #include <fstream>
+#include <algorithm>
 
 std::string getCurrentTimeStr() {
     auto now = std::time(nullptr);
@@ -23,18 +24,34 @@ std::string getCurrentTimeStr() {
 ServerThread::ServerThread(QObject* parent)
     : QThread(parent)
     , m_userMgr("Users.txt", TYPE_USER)
-    , m_logMgr("Log.txt", TYPE_LOG)
+    , m_log("Log.txt")
     , m_serverSock(INVALID_SOCKET)
     , m_isRunning(false)
+    , m_engine(this)
+    , m_sessions(m_engine)
+    , m_requests(m_files)
+    , m_history(m_files)
+    , m_writer(m_history, m_msgIds)
 {
+    m_log.setLevel(LogWriter::LEVEL_CHAT);
+    m_log.start();
+    m_history.start();
+    m_writer.setErrorHandler([this](const std::string& key) {
+        logToGui("Failed to store message for " + key, LogWriter::LEVEL_ERROR);
+    });
+    // 【新增】生成器从已存储的最大 ID 之后继续，重启前后时钟回拨也不会发出更小的 ID
+    m_msgIds.observe(m_history.recover());
+    m_writer.start();
+
     initGroupRecordFolder();
     initFriendRecordFolder();
+    m_friends.load();
+    m_requests.load();
 
     int pubGid = m_groupMgr.getGroupIdByName("公共聊天室");
     if (pubGid == -1) {
         pubGid = m_groupMgr.createGroup("公共聊天室", "");
         if (pubGid != -1) {
-            m_groupMgr.save();
             std::cout << "[System] Auto-created default group '公共聊天室' (ID: " << pubGid << ")" << std::endl;
         }
     }
@@ -45,9 +62,12 @@ ServerThread::~ServerThread() {
     if (m_serverSock != INVALID_SOCKET) {
         closesocket(m_serverSock);
     }
+    m_engine.stop();
     m_userMgr.save();
-    m_logMgr.save();
     m_groupMgr.save();
+    m_writer.stop();
+    m_history.stop();
+    m_log.stop();
     WSACleanup();
 }
 
@@ -55,26 +75,21 @@ void ServerThread::setPort(int port) {
     m_port = port;
 }
 
-void ServerThread::logToGui(std::string msg) {
-    std::lock_guard<std::mutex> lock(m_logMutex);
-    m_logMgr.addLog(msg);
-    emit logMessage(QString::fromStdString(msg));
+void ServerThread::setDurability(HistoryWriter::Durability mode, int syncIntervalMs) {
+    m_writer.setDurability(mode, syncIntervalMs);
+}
+
+void ServerThread::logToGui(std::string msg, LogWriter::Level level) {
+    if (!m_log.isEnabled(level)) return;
+    m_feed.push(msg);
+    m_log.write(level, std::move(msg));
 }
 
 std::string ServerThread::buildUserList() {
     std::string listStr = "CMD:USER_LIST|";
-    std::lock_guard<std::mutex> lock(m_userMutex);
-    for (auto const& [name, sock] : m_onlineUsers) {
-        int uid = 0;
-        std::vector<User> all = m_userMgr.getAllUsers();
-        for (auto& u : all) {
-            if (u.getUsername() == name) {
-                uid = u.getId();
-                break;
-            }
-        }
-        if (uid != 0) {
-            listStr += std::to_string(uid) + "," + name + ";";
+    for (const SessionPtr& s : m_sessions.getOnlineSessions()) {
+        if (s->getId() != 0) {
+            listStr += std::to_string(s->getId()) + "," + s->getName() + ";";
         }
     }
     listStr += "\n";
@@ -91,367 +106,188 @@ void ServerThread::initFriendRecordFolder() {
     if (!dir.exists()) dir.mkpath(".");
 }
 
-// 服务器端生成 UUID
-std::string ServerThread::generateUUID() {
-    srand((unsigned)time(NULL) + rand());
-    char buf[64];
-    sprintf_s(buf, sizeof(buf), "%lld-%d", (long long)time(NULL), rand());
-    return std::string(buf);
+// 【修改】交给写线程，消息 ID 在入队时生成并返回给调用方用于下发，保证存储与客户端看到的是同一个
+// 写入失败由写线程通过错误回调记录日志；strict 模式下这里会等到落盘才返回
+MessageId ServerThread::saveGroupMessageToFile(const std::string& groupName, int senderId, const std::string& sender, const std::string& content, const std::string& time) {
+    HistoryRecord rec;
+    rec.senderId = senderId;
+    rec.senderName = sender;
+    rec.content = content;
+    rec.time = time;
+    return m_writer.submit(HistoryStore::groupKey(groupName), std::move(rec));
 }
 
-void ServerThread::saveGroupMessageToFile(const std::string& groupName, int senderId, const std::string& sender, const std::string& content, const std::string& time) {
-    std::string path = "GroupRecord/" + groupName + ".txt";
-    std::ofstream ofs(path, std::ios::app);
-    if (ofs.is_open()) {
-        std::string uuid = generateUUID();
-        ofs << time << "|" << senderId << "|" << sender << "|" << content << "|" << uuid << "|" << "" << std::endl;
-        ofs.close();
-    }
+MessageId ServerThread::saveFriendMessageToFile(int id1, int id2, int senderId, const std::string& senderName, const std::string& content, const std::string& time) {
+    HistoryRecord rec;
+    rec.senderId = senderId;
+    rec.senderName = senderName;
+    rec.content = content;
+    rec.time = time;
+    return m_writer.submit(HistoryStore::friendKey(id1, id2), std::move(rec));
 }
 
-void ServerThread::saveFriendMessageToFile(int id1, int id2, int senderId, const std::string& senderName, const std::string& content, const std::string& time) {
-    int minId = (id1 < id2) ? id1 : id2;
-    int maxId = (id1 > id2) ? id1 : id2;
-    std::string path = "FriendRecord/" + std::to_string(minId) + "_" + std::to_string(maxId) + ".txt";
-
-    std::ofstream ofs(path, std::ios::app);
-    if (ofs.is_open()) {
-        std::string uuid = generateUUID();
-        ofs << time << "|" << senderId << "|" << senderName << "|" << content << "|" << uuid << "|" << "" << std::endl;
-        ofs.close();
-    }
+std::string ServerThread::buildHistoryPacket(int sessionId, int type, const HistoryRecord& rec) {
+    return "MSG:" + std::to_string(sessionId) + "|" + rec.senderName + "|" + rec.content + "|" + std::to_string(type) + "|"
+        + rec.time + "|" + std::to_string(rec.senderId) + "|" + MessageIdGenerator::toString(rec.id) + "\n";
 }
 
-std::vector<std::string> ServerThread::loadGroupHistory(const std::string& groupName, int requesterId) {
-    std::vector<std::string> history;
-    std::string path = "GroupRecord/" + groupName + ".txt";
-    std::ifstream ifs(path);
-    if (!ifs.is_open()) return history;
-    std::string line;
-    std::string delToken = "d" + std::to_string(requesterId) + ",";
-
-    while (std::getline(ifs, line)) {
-        if (!line.empty()) {
-            std::stringstream ss(line);
-            std::string segment;
-            std::vector<std::string> parts;
-            while (std::getline(ss, segment, '|')) parts.push_back(segment);
-
-            if (parts.size() >= 6) {
-                if (parts[5].find(delToken) != std::string::npos) {
-                    continue;
-                }
-            }
-            history.push_back(line);
-        }
+void ServerThread::sendHistoryPage(const SessionPtr& session, int type, int sessionId, MessageId beforeId, size_t limit) {
+    std::string key;
+    if (type == 1) {
+        std::string gName = m_groupMgr.getGroupName(sessionId);
+        if (gName == "Unknown") return;
+        key = HistoryStore::groupKey(gName);
     }
-    return history;
-}
-
-std::vector<std::string> ServerThread::loadFriendHistory(int id1, int id2, int requesterId) {
-    std::vector<std::string> history;
-    int minId = (id1 < id2) ? id1 : id2;
-    int maxId = (id1 > id2) ? id1 : id2;
-    std::string path = "FriendRecord/" + std::to_string(minId) + "_" + std::to_string(maxId) + ".txt";
-    std::ifstream ifs(path);
-    if (!ifs.is_open()) return history;
-    std::string line;
-    std::string delToken = "d" + std::to_string(requesterId) + ",";
-
-    while (std::getline(ifs, line)) {
-        if (!line.empty()) {
-            std::stringstream ss(line);
-            std::string segment;
-            std::vector<std::string> parts;
-            while (std::getline(ss, segment, '|')) parts.push_back(segment);
-
-            if (parts.size() >= 6) {
-                if (parts[5].find(delToken) != std::string::npos) {
-                    continue;
-                }
-            }
-            history.push_back(line);
-        }
+    else {
+        key = HistoryStore::friendKey(session->getId(), sessionId);
     }
-    return history;
+
+    // 之前入队的消息要先写进存储，否则刚发的消息可能不在这一页里
+    m_writer.waitApplied(key);
+    MessageId cursor = 0;
+    std::vector<HistoryRecord> page = m_history.readBefore(key, beforeId, std::min(limit, kHistoryPageMax), session->getId(), &cursor);
+
+    // 整页拼成一个缓冲区，一次入队
+    std::string head = std::to_string(type) + "|" + std::to_string(sessionId);
+    std::string out = "CMD:HISTORY_BEGIN|" + head + "|" + MessageIdGenerator::toString(cursor) + "\n";
+    for (const auto& rec : page) out += buildHistoryPacket(sessionId, type, rec);
+    out += "CMD:HISTORY_END|" + head + "\n";
+    session->send(out);
 }
 
-void ServerThread::handleDeleteMessage(SOCKET clientSock, int myId, const std::string& uuid) {
-    int gid = getClientGroupState(clientSock);
-    int fid = getClientFriendState(clientSock);
+void ServerThread::handleDeleteMessage(const SessionPtr& session, const std::string& uuid) {
+    int myId = session->getId();
+    int gid = session->getViewingGroup();
+    int fid = session->getViewingFriend();
 
-    std::string path = "";
+    // 旧记录导入时已换成数字 ID，解析不了的 ID 不可能存在
+    MessageId msgId = 0;
+    if (!MessageIdGenerator::parse(uuid, msgId)) return;
+
+    std::string key = "";
     bool isGroup = false;
 
     if (gid != -1) {
         std::string gName = m_groupMgr.getGroupName(gid);
         if (gName != "Unknown") {
-            path = "GroupRecord/" + gName + ".txt";
+            key = HistoryStore::groupKey(gName);
             isGroup = true;
         }
     }
     else if (fid != -1) {
-        int minId = (myId < fid) ? myId : fid;
-        int maxId = (myId > fid) ? myId : fid;
-        path = "FriendRecord/" + std::to_string(minId) + "_" + std::to_string(maxId) + ".txt";
+        key = HistoryStore::friendKey(myId, fid);
     }
 
-    if (!path.empty()) {
-        updateFileForDelete(path, uuid, myId);
+    if (!key.empty()) {
+        m_writer.waitApplied(key);
+        if (!m_history.hideMessage(key, msgId, myId)) return;
 
         std::string clearCmd = "CMD:CLEAR_CHAT\n";
-        send(clientSock, clearCmd.c_str(), (int)clearCmd.length(), 0);
-
-        std::vector<std::string> history;
-        if (isGroup) history = loadGroupHistory(m_groupMgr.getGroupName(gid), myId);
-        else history = loadFriendHistory(myId, fid, myId);
-
-        for (const auto& line : history) {
-            std::stringstream ss(line);
-            std::string item;
-            std::vector<std::string> parts;
-            while (std::getline(ss, item, '|')) parts.push_back(item);
-
-            if (parts.size() >= 5) {
-                std::string packet;
-                if (isGroup) {
-                    packet = "MSG:" + std::to_string(gid) + "|" + parts[2] + "|" + parts[3] + "|1|" + parts[0] + "|" + parts[1] + "|" + parts[4] + "\n";
-                }
-                else {
-                    packet = "MSG:" + std::to_string(fid) + "|" + parts[2] + "|" + parts[3] + "|0|" + parts[0] + "|" + parts[1] + "|" + parts[4] + "\n";
-                }
-                send(clientSock, packet.c_str(), (int)packet.length(), 0);
-            }
-        }
+        session->send(clearCmd);
+        if (isGroup) sendHistoryPage(session, 1, gid, 0, kHistoryPageSize);
+        else sendHistoryPage(session, 0, fid, 0, kHistoryPageSize);
         logToGui("User " + std::to_string(myId) + " deleted msg " + uuid);
     }
 }
 
-void ServerThread::updateFileForDelete(const std::string& filePath, const std::string& uuid, int myId) {
-    std::vector<std::string> lines;
-    std::ifstream ifs(filePath);
-    if (!ifs.is_open()) return;
-
-    std::string line;
-    std::string searchUUID = "|" + uuid + "|";
-    while (std::getline(ifs, line)) {
-        if (line.find(searchUUID) != std::string::npos) {
-            while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) line.pop_back();
-            line += "d" + std::to_string(myId) + ",";
-        }
-        lines.push_back(line);
-    }
-    ifs.close();
-
-    std::ofstream ofs(filePath, std::ios::trunc);
-    for (const auto& l : lines) {
-        ofs << l << std::endl;
-    }
-}
-
+// 【修改】直接查好友索引，不再列目录
 std::string ServerThread::getFriendsListCmd(int userId) {
     std::string listCmd = "CMD:FRIEND_LIST|";
-    QDir dir("FriendRecord");
-    QStringList filters;
-    filters << "*.txt";
-    QFileInfoList fileList = dir.entryInfoList(filters, QDir::Files);
-
-    std::vector<User> allUsers = m_userMgr.getAllUsers();
-
-    for (const QFileInfo& fileInfo : fileList) {
-        QString fileName = fileInfo.baseName();
-        QStringList ids = fileName.split('_');
-        if (ids.size() == 2) {
-            int id1 = ids[0].toInt();
-            int id2 = ids[1].toInt();
-            int friendId = -1;
-
-            if (id1 == userId) friendId = id2;
-            else if (id2 == userId) friendId = id1;
-
-            if (friendId != -1) {
-                std::string friendName = "Unknown";
-                for (const auto& u : allUsers) {
-                    if (u.getId() == friendId) {
-                        friendName = u.getUsername();
-                        break;
-                    }
-                }
+    for (int friendId : m_friends.getFriends(userId)) {
+        std::string friendName = "Unknown";
+        if (const User* u = m_userMgr.findById(friendId)) friendName = u->getUsername();
 
-                int status = 0;
-                {
-                    std::lock_guard<std::mutex> lock(m_userMutex);
-                    if (m_onlineUsers.count(friendName)) status = 1;
-                }
+        int status = m_sessions.findById(friendId) ? 1 : 0;
 
-                listCmd += std::to_string(friendId) + "," + friendName + "," + std::to_string(status) + ";";
-            }
-        }
+        listCmd += std::to_string(friendId) + "," + friendName + "," + std::to_string(status) + ";";
     }
     listCmd += "\n";
     return listCmd;
 }
 
-void ServerThread::setClientGroupState(SOCKET s, int gid) {
-    std::lock_guard<std::mutex> lock(m_groupStateMutex);
-    m_clientGroupMap[s] = gid;
-}
-
-int ServerThread::getClientGroupState(SOCKET s) {
-    std::lock_guard<std::mutex> lock(m_groupStateMutex);
-    if (m_clientGroupMap.count(s)) return m_clientGroupMap[s];
-    return -1;
-}
-
-void ServerThread::setClientFriendState(SOCKET s, int fid) {
-    std::lock_guard<std::mutex> lock(m_friendStateMutex);
-    m_clientFriendMap[s] = fid;
-}
+// 【修改】成员和权限一次取出；结果按群版本缓存，在线位由 broadcastStatusChange 就地改写
+NetEngine::Buffer ServerThread::buildGroupMembersCmd(int gid) {
+    uint64_t version = 0;
+    if (m_groupMgr.getGroupVersion(gid, version)) {
+        if (NetEngine::Buffer cached = m_rosters.find(gid, version)) return cached;
+    }
 
-int ServerThread::getClientFriendState(SOCKET s) {
-    std::lock_guard<std::mutex> lock(m_friendStateMutex);
-    if (m_clientFriendMap.count(s)) return m_clientFriendMap[s];
-    return -1;
+    uint64_t epoch = m_rosters.getPresenceEpoch();
+    std::vector<GroupManager::RosterEntry> roster;
+    if (!m_groupMgr.getRoster(gid, roster, version)) return NetEngine::makeBuffer("CMD:GROUP_MEMBERS|\n");
+
+    std::string resp = "CMD:GROUP_MEMBERS|";
+    std::vector<std::pair<std::string, size_t>> statusOffsets;
+    statusOffsets.reserve(roster.size());
+    for (const auto& m : roster) {
+        const User* mem = m_userMgr.findByName(m.name);
+        if (!mem) continue;
+        resp += std::to_string(mem->getId()) + "," + m.name + ",";
+        statusOffsets.emplace_back(m.name, resp.size());
+        resp += m_sessions.isOnline(m.name) ? '1' : '0';
+        resp += "," + std::to_string(m.role) + ";";
+    }
+    resp += "\n";
+    return m_rosters.store(gid, version, epoch, std::move(resp), std::move(statusOffsets));
 }
 
 void ServerThread::broadcastStatusChange(int userId, std::string userName, int status) {
-    std::string packet = "CMD:STATUS_UPDATE|" + std::to_string(userId) + "|" + std::to_string(status) + "\n";
-    std::lock_guard<std::mutex> lock(m_userMutex);
-    for (auto const& [name, sock] : m_onlineUsers) {
-        if (name == userName) continue;
-        send(sock, packet.c_str(), (int)packet.length(), 0);
+    // 同名的另一个连接可能仍在线，以会话表为准；在缓存锁内查询，避免与重连交错时写回旧状态
+    m_rosters.setPresence(userName, [this, &userName] { return m_sessions.isOnline(userName); }, m_groupMgr.getUserGroups(userName));
+
+    NetEngine::Buffer packet = NetEngine::makeBuffer("CMD:STATUS_UPDATE|" + std::to_string(userId) + "|" + std::to_string(status) + "\n");
+    for (const SessionPtr& s : m_sessions.getOnlineSessions()) {
+        if (s->getName() == userName) continue;
+        s->send(packet, NetEngine::SEND_DROPPABLE);
     }
 }
 
+// 【修改】申请存进按目标建索引的 RequestStore，重复申请不再追加
 void ServerThread::saveRequest(std::string type, int fromId, std::string fromName, int targetId) {
-    {
-        std::lock_guard<std::mutex> lock(m_requestMutex);
-        std::ofstream ofs(m_requestFile, std::ios::app);
-        if (ofs.is_open()) {
-            ofs << type << "|" << fromId << "|" << fromName << "|" << targetId << std::endl;
-            ofs.close();
-        }
-    }
-    checkAndPushRequestUpdate(targetId);
+    PendingRequest req;
+    req.type = type;
+    req.fromId = fromId;
+    req.fromName = fromName;
+    req.targetId = targetId;
+    if (m_requests.add(req)) pushRequestDelta(req, true);
 }
 
-void ServerThread::checkAndPushRequestUpdate(int targetId) {
-    std::vector<SOCKET> socketsToPush;
-
-    {
-        std::lock_guard<std::mutex> lock(m_userMutex);
-        std::lock_guard<std::mutex> viewLock(m_viewingReqMutex);
-
-        for (const auto& [name, sock] : m_onlineUsers) {
-            if (m_viewingRequestSockets.count(sock)) {
-                socketsToPush.push_back(sock);
-            }
-        }
+void ServerThread::pushRequestDelta(const PendingRequest& req, bool added) {
+    std::vector<SessionPtr> targets;
+    if (req.type == "FRIEND") {
+        if (SessionPtr s = m_sessions.findById(req.targetId)) targets.push_back(s);
     }
-
-    for (SOCKET s : socketsToPush) {
-        int uid = 0;
-        std::string uname = "";
-        {
-            std::lock_guard<std::mutex> lock(m_userMutex);
-            for (auto& p : m_onlineUsers) if (p.second == s) { uname = p.first; break; }
-        }
-
-        if (!uname.empty()) {
-            std::vector<User> all = m_userMgr.getAllUsers();
-            for (auto& u : all) if (u.getUsername() == uname) { uid = u.getId(); break; }
+    else if (req.type == "GROUP") {
+        for (const std::string& name : m_groupMgr.getGroupManagers(req.targetId)) {
+            if (SessionPtr s = m_sessions.findByName(name)) targets.push_back(s);
         }
+    }
 
-        if (uid != 0) {
-            std::string resp = loadRequestsForUser(uid, uname);
-            send(s, resp.c_str(), (int)resp.length(), 0);
-        }
+    std::string delta = added
+        ? "CMD:REQUEST_ADDED|" + req.type + "," + std::to_string(req.fromId) + "," + req.fromName + "," + std::to_string(req.targetId) + "\n"
+        : "CMD:REQUEST_REMOVED|" + req.type + "," + std::to_string(req.fromId) + "," + std::to_string(req.targetId) + "\n";
+    for (const SessionPtr& s : targets) {
+        if (s->isViewingRequests()) s->send(delta);
     }
 }
 
+// 【修改】只看发给自己的好友申请，以及自己能管理的群的入群申请
 std::string ServerThread::loadRequestsForUser(int userId, std::string userName) {
-    std::lock_guard<std::mutex> lock(m_requestMutex);
-    std::ifstream ifs(m_requestFile);
-    if (!ifs.is_open()) return "CMD:REQUEST_LIST|\n";
-
-    std::string line;
     std::string listStr = "CMD:REQUEST_LIST|";
-
-    while (std::getline(ifs, line)) {
-        if (line.empty()) continue;
-        std::stringstream ss(line);
-        std::string type, fromIdStr, fromName, targetIdStr;
-        std::getline(ss, type, '|');
-        std::getline(ss, fromIdStr, '|');
-        std::getline(ss, fromName, '|');
-        std::getline(ss, targetIdStr, '|');
-
-        try {
-            if (targetIdStr.empty() || fromIdStr.empty()) continue;
-
-            int targetId = std::stoi(targetIdStr);
-            int fromId = std::stoi(fromIdStr);
-
-            bool isForMe = false;
-            if (type == "FRIEND" && targetId == userId) {
-                isForMe = true;
-            }
-            else if (type == "GROUP") {
-                if (m_groupMgr.checkPermission(targetId, userName, ROLE_ADMIN)) {
-                    isForMe = true;
-                }
-            }
-
-            if (isForMe) {
-                listStr += type + "," + fromIdStr + "," + fromName + "," + targetIdStr + ";";
-            }
-        }
-        catch (...) {
-            continue;
-        }
+    auto appendItem = [&listStr](const PendingRequest& req) {
+        listStr += req.type + "," + std::to_string(req.fromId) + "," + req.fromName + "," + std::to_string(req.targetId) + ";";
+    };
+
+    for (const PendingRequest& req : m_requests.getForUser(userId)) appendItem(req);
+    // 只看自己所在的群，不遍历全服有申请的群
+    for (int gid : m_groupMgr.getUserGroups(userName)) {
+        if (m_groupMgr.getUserRole(gid, userName) < ROLE_ADMIN) continue;
+        for (const PendingRequest& req : m_requests.getForGroup(gid)) appendItem(req);
     }
     listStr += "\n";
     return listStr;
 }
 
-void ServerThread::removeRequest(std::string type, int fromId, int targetId) {
-    std::lock_guard<std::mutex> lock(m_requestMutex);
-    std::ifstream ifs(m_requestFile);
-    if (!ifs.is_open()) return;
-
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(ifs, line)) {
-        if (line.empty()) continue;
-        std::stringstream ss(line);
-        std::string t, fStr, fName, tStr;
-        std::getline(ss, t, '|');
-        std::getline(ss, fStr, '|');
-        std::getline(ss, fName, '|');
-        std::getline(ss, tStr, '|');
-
-        try {
-            if (fStr.empty() || tStr.empty()) {
-                continue;
-            }
-
-            if (t == type && std::stoi(fStr) == fromId && std::stoi(tStr) == targetId) {
-                continue;
-            }
-        }
-        catch (...) {
-            continue;
-        }
-        lines.push_back(line);
-    }
-    ifs.close();
-
-    std::ofstream ofs(m_requestFile, std::ios::trunc);
-    for (const auto& l : lines) {
-        ofs << l << std::endl;
-    }
-}
-
 void ServerThread::handleRequestDecision(std::string decisionStr) {
     std::stringstream ss(decisionStr);
     std::string type, fromIdStr, targetIdStr, resultStr;
@@ -464,82 +300,63 @@ void ServerThread::handleRequestDecision(std::string decisionStr) {
     int targetId = std::stoi(targetIdStr);
     bool accepted = (resultStr == "1");
 
-    removeRequest(type, fromId, targetId);
+    // 同一个群的其他管理员也在看列表时同步去掉这一条
+    PendingRequest decided;
+    decided.type = type;
+    decided.fromId = fromId;
+    decided.targetId = targetId;
+    if (m_requests.remove(type, fromId, targetId)) pushRequestDelta(decided, false);
 
     if (!accepted) return;
 
     if (type == "FRIEND") {
         std::string fromName = "";
-        auto users = m_userMgr.getAllUsers();
-        for (auto& u : users) if (u.getId() == fromId) fromName = u.getUsername();
+        if (const User* u = m_userMgr.findById(fromId)) fromName = u->getUsername();
 
         std::string targetName = "";
-        for (auto& u : users) if (u.getId() == targetId) targetName = u.getUsername();
+        if (const User* u = m_userMgr.findById(targetId)) targetName = u->getUsername();
 
         if (!fromName.empty() && !targetName.empty()) {
+            m_friends.addFriendship(fromId, targetId);
             saveFriendMessageToFile(fromId, targetId, 0, "System", "Friend Added", getCurrentTimeStr());
             logToGui("[Request] Friend request accepted: " + fromName + " <-> " + targetName);
 
             // =========================================================
             // 【核心修复】死锁解决 + 状态缓存
             // =========================================================
-            SOCKET fromSock = INVALID_SOCKET;
-            SOCKET targetSock = INVALID_SOCKET;
-            bool isFromOnline = false;
-            bool isTargetOnline = false;
-
-            {
-                std::lock_guard<std::mutex> lock(m_userMutex);
-                if (m_onlineUsers.count(fromName)) {
-                    fromSock = m_onlineUsers[fromName];
-                    isFromOnline = true;
-                }
-                if (m_onlineUsers.count(targetName)) {
-                    targetSock = m_onlineUsers[targetName];
-                    isTargetOnline = true;
-                }
-            }
+            SessionPtr fromSession = m_sessions.findById(fromId);
+            SessionPtr targetSession = m_sessions.findById(targetId);
 
-            if (isFromOnline && fromSock != INVALID_SOCKET) {
+            if (fromSession) {
                 std::string list1 = getFriendsListCmd(fromId);
-                send(fromSock, list1.c_str(), (int)list1.length(), 0);
+                fromSession->send(list1);
 
-                int statusVal = isTargetOnline ? 1 : 0;
+                int statusVal = targetSession ? 1 : 0;
                 std::string statusMsg = "CMD:STATUS_UPDATE|" + std::to_string(targetId) + "|" + std::to_string(statusVal) + "\n";
-                send(fromSock, statusMsg.c_str(), (int)statusMsg.length(), 0);
+                fromSession->send(statusMsg);
             }
 
-            if (isTargetOnline && targetSock != INVALID_SOCKET) {
+            if (targetSession) {
                 std::string list2 = getFriendsListCmd(targetId);
-                send(targetSock, list2.c_str(), (int)list2.length(), 0);
+                targetSession->send(list2);
 
-                int statusVal = isFromOnline ? 1 : 0;
+                int statusVal = fromSession ? 1 : 0;
                 std::string statusMsg = "CMD:STATUS_UPDATE|" + std::to_string(fromId) + "|" + std::to_string(statusVal) + "\n";
-                send(targetSock, statusMsg.c_str(), (int)statusMsg.length(), 0);
+                targetSession->send(statusMsg);
             }
         }
     }
     else if (type == "GROUP") {
         std::string fromName = "";
-        auto users = m_userMgr.getAllUsers();
-        for (auto& u : users) if (u.getId() == fromId) fromName = u.getUsername();
+        if (const User* u = m_userMgr.findById(fromId)) fromName = u->getUsername();
 
         if (!fromName.empty()) {
             if (m_groupMgr.joinGroup(targetId, fromName)) {
-                m_groupMgr.save();
                 logToGui("[Request] Group join accepted: " + fromName + " -> Group " + std::to_string(targetId));
 
-                SOCKET fromSock = INVALID_SOCKET;
-                {
-                    std::lock_guard<std::mutex> lock(m_userMutex);
-                    if (m_onlineUsers.count(fromName)) {
-                        fromSock = m_onlineUsers[fromName];
-                    }
-                }
-
-                if (fromSock != INVALID_SOCKET) {
+                if (SessionPtr fromSession = m_sessions.findById(fromId)) {
                     std::string list = m_groupMgr.getMyGroupListCmd(fromName) + "\n";
-                    send(fromSock, list.c_str(), (int)list.length(), 0);
+                    fromSession->send(list);
                 }
             }
         }
@@ -549,13 +366,13 @@ void ServerThread::handleRequestDecision(std::string decisionStr) {
 void ServerThread::run() {
     WSADATA wsaData;
     if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
-        emit logMessage("Error: WSAStartup failed.");
+        m_feed.push("Error: WSAStartup failed.");
         return;
     }
 
     m_serverSock = socket(AF_INET, SOCK_STREAM, 0);
     if (m_serverSock == INVALID_SOCKET) {
-        emit logMessage("Error: Creating socket failed.");
+        m_feed.push("Error: Creating socket failed.");
         return;
     }
 
@@ -565,22 +382,31 @@ void ServerThread::run() {
     addr.sin_addr.s_addr = INADDR_ANY;
 
     if (::bind(m_serverSock, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
-        emit logMessage("Error: Bind failed. Port might be in use.");
+        m_feed.push("Error: Bind failed. Port might be in use.");
+        closesocket(m_serverSock);
+        m_serverSock = INVALID_SOCKET;
+        return;
+    }
+
+    if (listen(m_serverSock, SOMAXCONN) == SOCKET_ERROR) {
+        m_feed.push("Error: Listen failed.");
         closesocket(m_serverSock);
         m_serverSock = INVALID_SOCKET;
         return;
     }
 
-    if (listen(m_serverSock, 5) == SOCKET_ERROR) {
-        emit logMessage("Error: Listen failed.");
+    if (!m_engine.start()) {
+        m_feed.push("Error: Starting I/O engine failed.");
         closesocket(m_serverSock);
         m_serverSock = INVALID_SOCKET;
         return;
     }
 
     m_isRunning = true;
-    emit logMessage(">>> Server started on port " + QString::number(m_port));
-    emit logMessage(">>> Waiting for connections...");
+    m_feed.push(">>> Server started on port " + std::to_string(m_port));
+    m_feed.push(">>> I/O threads: " + std::to_string(m_engine.ioThreadCount()));
+    m_feed.push(std::string(">>> History durability: ") + HistoryWriter::durabilityName(m_writer.durability()));
+    m_feed.push(">>> Waiting for connections...");
 
     while (m_isRunning) {
         SOCKADDR_IN clientAddr = {};
@@ -590,518 +416,427 @@ void ServerThread::run() {
         if (!m_isRunning) break;
 
         if (sockClient != INVALID_SOCKET) {
-            ThreadInfo* info = new ThreadInfo;
-            info->sock = sockClient;
-            info->pServer = this;
-            CreateThread(NULL, 0, ClientHandlerStatic, (LPVOID)info, 0, NULL);
+            if (!m_engine.addConnection(sockClient)) closesocket(sockClient);
         }
     }
+    m_engine.stop();
+}
+
+// --- 客户端处理 (由 NetEngine 的 I/O 线程驱动) ---
+
+void ServerThread::onConnect(SOCKET s) {
+    m_sessions.create(s);
+}
+
+void ServerThread::onFrame(SOCKET s, const std::string& frame) {
+    SessionPtr session = m_sessions.findBySocket(s);
+    if (!session) return;
+    session->countFrame();
+
+    if (!session->isLoggedIn()) handleLogin(session, frame);
+    else handleClientMessage(session, frame);
 }
 
-// --- 客户端处理 ---
+void ServerThread::onDisconnect(SOCKET sockClient) {
+    SessionPtr session = m_sessions.remove(sockClient);
+    if (!session || !session->isLoggedIn()) return;
+
+    std::string clientName = session->getName();
+    int clientId = session->getId();
+    logToGui("User [" + clientName + "] disconnected.");
 
-DWORD WINAPI ServerThread::ClientHandlerStatic(LPVOID lpParam) {
-    ThreadInfo* info = (ThreadInfo*)lpParam;
-    SOCKET sockClient = info->sock;
-    ServerThread* server = info->pServer;
+    broadcastStatusChange(clientId, clientName, 0);
 
+    NetEngine::Buffer newUserList = NetEngine::makeBuffer(buildUserList());
+    for (const SessionPtr& s : m_sessions.getOnlineSessions()) {
+        s->send(newUserList, NetEngine::SEND_DROPPABLE);
+    }
+}
+
+void ServerThread::handleLogin(const SessionPtr& session, const std::string& rawMsg) {
     std::string clientName = "";
     int clientId = 0;
 
-    char szData[2048] = { 0 };
-    int len = recv(sockClient, szData, 2047, 0);
+    std::string password = "";
 
-    if (len > 0) {
-        szData[len] = '\0';
-        std::string rawMsg = szData;
-        while (!rawMsg.empty() && (rawMsg.back() == '\r' || rawMsg.back() == '\n'))
-            rawMsg.pop_back();
+    if (rawMsg.find("CMD:LOGIN|") == 0) {
+        std::string body = rawMsg.substr(10);
+        std::stringstream ss(body);
+        std::string segment;
+        std::vector<std::string> parts;
+        while (std::getline(ss, segment, '|')) parts.push_back(segment);
 
-        std::string password = "";
+        if (parts.size() >= 2) {
+            clientName = parts[0];
+            password = parts[1];
+        }
+        else {
+            session->close();
+            return;
+        }
+    }
+    else {
+        clientName = rawMsg;
+        password = "123456";
+    }
 
-        if (rawMsg.find("CMD:LOGIN|") == 0) {
-            std::string body = rawMsg.substr(10);
-            std::stringstream ss(body);
-            std::string segment;
-            std::vector<std::string> parts;
-            while (std::getline(ss, segment, '|')) parts.push_back(segment);
+    if (!clientName.empty()) {
+        const User* existingUser = m_userMgr.findByName(clientName);
 
-            if (parts.size() >= 2) {
-                clientName = parts[0];
-                password = parts[1];
+        if (existingUser != nullptr) {
+            if (existingUser->getPassword() == password) {
+                clientId = existingUser->getId();
+                logToGui("User [" + clientName + "] login success.");
             }
             else {
-                closesocket(sockClient); delete info; return 0;
+                std::string failMsg = "CMD:LOGIN_FAIL|Wrong Password\n";
+                session->send(failMsg);
+                logToGui("User [" + clientName + "] login failed (wrong password).");
+                session->close();
+                return;
             }
         }
         else {
-            clientName = rawMsg;
-            password = "123456";
-        }
-
-        if (!clientName.empty()) {
-            std::vector<User> all = server->m_userMgr.getAllUsers();
-            User* existingUser = nullptr;
-            for (auto& u : all) {
-                if (u.getUsername() == clientName) {
-                    existingUser = &u;
-                    break;
-                }
+            clientId = m_userMgr.getNextId();
+            if (!m_userMgr.addUser(User(clientId, clientName, password, "127.0.0.1"))) {
+                // 同名用户在另一个连接上刚好抢先注册
+                std::string failMsg = "CMD:LOGIN_FAIL|Name Taken\n";
+                session->send(failMsg);
+                session->close();
+                return;
             }
+            logToGui("[System] Registered new User " + clientName + " ID:" + std::to_string(clientId));
 
-            if (existingUser != nullptr) {
-                if (existingUser->getPassword() == password) {
-                    clientId = existingUser->getId();
-                    server->logToGui("User [" + clientName + "] login success.");
-                }
-                else {
-                    std::string failMsg = "CMD:LOGIN_FAIL|Wrong Password\n";
-                    send(sockClient, failMsg.c_str(), (int)failMsg.length(), 0);
-                    server->logToGui("User [" + clientName + "] login failed (wrong password).");
-                    closesocket(sockClient); delete info; return 0;
-                }
-            }
-            else {
-                clientId = server->m_userMgr.getNextId();
-                server->m_userMgr.addUser(User(clientId, clientName, password, "127.0.0.1"));
-                server->logToGui("[System] Registered new User " + clientName + " ID:" + std::to_string(clientId));
-
-                int pubGid = server->m_groupMgr.getGroupIdByName("公共聊天室");
-                if (pubGid != -1) {
-                    if (server->m_groupMgr.joinGroup(pubGid, clientName)) {
-                        server->m_groupMgr.save();
-                        server->logToGui("[System] User " + clientName + " auto-joined '公共聊天室'");
-                    }
+            int pubGid = m_groupMgr.getGroupIdByName("公共聊天室");
+            if (pubGid != -1) {
+                if (m_groupMgr.joinGroup(pubGid, clientName)) {
+                    logToGui("[System] User " + clientName + " auto-joined '公共聊天室'");
                 }
             }
         }
+    }
 
-        {
-            std::lock_guard<std::mutex> lock(server->m_userMutex);
-            server->m_onlineUsers[clientName] = sockClient;
-        }
-        server->setClientGroupState(sockClient, -1);
-        server->setClientFriendState(sockClient, -1);
+    m_sessions.bindUser(session, clientId, clientName);
 
-        std::string loginMsg = "CMD:LOGIN_SUCCESS|" + std::to_string(clientId) + "\n";
-        send(sockClient, loginMsg.c_str(), (int)loginMsg.length(), 0);
+    std::string loginMsg = "CMD:LOGIN_SUCCESS|" + std::to_string(clientId) + "\n";
+    session->send(loginMsg);
 
-        if (AdminManager::getUserGroup(clientName) == GROUP_ADMIN) {
-            std::string adminMsg = "CMD:GRANT_ADMIN\n";
-            send(sockClient, adminMsg.c_str(), (int)adminMsg.length(), 0);
-            std::string welcome = "[System] Welcome Administrator " + clientName + "\n";
-            send(sockClient, welcome.c_str(), (int)welcome.length(), 0);
-        }
+    if (AdminManager::getUserGroup(clientName) == GROUP_ADMIN) {
+        std::string adminMsg = "CMD:GRANT_ADMIN\n";
+        session->send(adminMsg);
+        std::string welcome = "[System] Welcome Administrator " + clientName + "\n";
+        session->send(welcome);
+    }
 
-        server->broadcastStatusChange(clientId, clientName, 1);
+    broadcastStatusChange(clientId, clientName, 1);
 
-        std::string userList = server->buildUserList();
-        {
-            std::lock_guard<std::mutex> lock(server->m_userMutex);
-            for (auto const& [name, sock] : server->m_onlineUsers) {
-                send(sock, userList.c_str(), (int)userList.length(), 0);
-            }
-        }
+    NetEngine::Buffer userList = NetEngine::makeBuffer(buildUserList());
+    for (const SessionPtr& s : m_sessions.getOnlineSessions()) {
+        s->send(userList, NetEngine::SEND_DROPPABLE);
     }
-    else {
-        closesocket(sockClient);
-        delete info;
-        return 0;
+}
+
+void ServerThread::handleClientMessage(const SessionPtr& session, const std::string& rawMsg) {
+    const std::string& clientName = session->getName();
+    int clientId = session->getId();
+
+    if (rawMsg.find("/delete ") == 0) {
+        std::string uuid = rawMsg.substr(8);
+        handleDeleteMessage(session, uuid);
+        return;
     }
 
-    while (true)
-    {
-        char szRecv[4096] = { 0 };
-        int ret = recv(sockClient, szRecv, 4095, 0);
+    if (rawMsg.find("/friend_add ") == 0) {
+        std::string arg = rawMsg.substr(12);
+        int targetId = 0;
+        bool isDigit = !arg.empty();
+        for (char c : arg) if (!isdigit(c)) isDigit = false;
 
-        if (ret > 0)
-        {
-            szRecv[ret] = '\0';
-            std::string rawMsg = szRecv;
-            while (!rawMsg.empty() && (rawMsg.back() == '\r' || rawMsg.back() == '\n'))
-                rawMsg.pop_back();
-
-            if (rawMsg.find("/delete ") == 0) {
-                std::string uuid = rawMsg.substr(8);
-                server->handleDeleteMessage(sockClient, clientId, uuid);
-                continue;
-            }
+        if (isDigit) {
+            int id = std::stoi(arg);
+            if (m_userMgr.findById(id)) targetId = id;
+        }
+        if (targetId == 0) {
+            if (const User* u = m_userMgr.findByName(arg)) targetId = u->getId();
+        }
 
-            if (rawMsg.find("/friend_add ") == 0) {
-                std::string arg = rawMsg.substr(12);
-                int targetId = 0;
-                bool isDigit = !arg.empty();
-                for (char c : arg) if (!isdigit(c)) isDigit = false;
+        if (targetId != 0 && targetId != clientId) {
+            saveRequest("FRIEND", clientId, clientName, targetId);
+            std::string msg = "[System] Friend request sent to " + arg + "\n";
+            session->send(msg);
+        }
+        else {
+            std::string msg = "[Error] User not found: " + arg + "\n";
+            session->send(msg);
+        }
+        return;
+    }
 
-                if (isDigit) {
-                    int id = std::stoi(arg);
-                    auto users = server->m_userMgr.getAllUsers();
-                    for (auto& u : users) if (u.getId() == id) { targetId = id; break; }
-                }
-                if (targetId == 0) {
-                    auto users = server->m_userMgr.getAllUsers();
-                    for (auto& u : users) if (u.getUsername() == arg) { targetId = u.getId(); break; }
-                }
+    if (rawMsg.find("/g_join ") == 0) {
+        std::string arg = rawMsg.substr(8);
+        int gid = 0;
+        bool isDigit = !arg.empty();
+        for (char c : arg) if (!isdigit(c)) isDigit = false;
+        if (isDigit) {
+            int id = std::stoi(arg);
+            if (m_groupMgr.getGroupName(id) != "Unknown") gid = id;
+        }
+        if (gid == 0) gid = m_groupMgr.getGroupIdByName(arg);
+
+        if (gid != 0) {
+            saveRequest("GROUP", clientId, clientName, gid);
+            std::string gName = m_groupMgr.getGroupName(gid);
+            std::string promptName = gName + "(ID:" + std::to_string(gid) + ")";
+            std::string msg = "[System] Join request sent to Group " + promptName + "\n";
+            session->send(msg);
+        }
+        else {
+            std::string msg = "[Error] Group not found: " + arg + "\n";
+            session->send(msg);
+        }
+        return;
+    }
 
-                if (targetId != 0 && targetId != clientId) {
-                    server->saveRequest("FRIEND", clientId, clientName, targetId);
-                    std::string msg = "[System] Friend request sent to " + arg + "\n";
-                    send(sockClient, msg.c_str(), (int)msg.length(), 0);
-                }
-                else {
-                    std::string msg = "[Error] User not found: " + arg + "\n";
-                    send(sockClient, msg.c_str(), (int)msg.length(), 0);
-                }
-                continue;
-            }
+    // 【新增】按群名前缀搜索：CMD:GROUP_SEARCH|前缀|最多条数
+    if (rawMsg.find("CMD:GROUP_SEARCH|") == 0) {
+        std::string body = rawMsg.substr(17);
+        size_t sep = body.rfind('|');
+        std::string prefix = body.substr(0, sep);
+        size_t limit = 10;
+        if (sep != std::string::npos) {
+            int n = atoi(body.c_str() + sep + 1);
+            if (n > 0) limit = (size_t)n;
+        }
+        session->send(m_groupMgr.getGroupSearchCmd(prefix, limit) + "\n");
+        return;
+    }
 
-            if (rawMsg.find("/g_join ") == 0) {
-                std::string arg = rawMsg.substr(8);
-                int gid = 0;
-                bool isDigit = !arg.empty();
-                for (char c : arg) if (!isdigit(c)) isDigit = false;
-                if (isDigit) {
-                    int id = std::stoi(arg);
-                    if (server->m_groupMgr.getGroupName(id) != "Unknown") gid = id;
-                }
-                if (gid == 0) gid = server->m_groupMgr.getGroupIdByName(arg);
-
-                if (gid != 0) {
-                    server->saveRequest("GROUP", clientId, clientName, gid);
-                    std::string gName = server->m_groupMgr.getGroupName(gid);
-                    std::string promptName = gName + "(ID:" + std::to_string(gid) + ")";
-                    std::string msg = "[System] Join request sent to Group " + promptName + "\n";
-                    send(sockClient, msg.c_str(), (int)msg.length(), 0);
+    if (rawMsg.find("CMD:KICK_MEMBER|") == 0) {
+        std::string body = rawMsg.substr(16);
+        std::stringstream ss(body);
+        std::string sGid, sTid;
+        std::getline(ss, sGid, '|'); std::getline(ss, sTid, '|');
+        int gid = std::stoi(sGid);
+        int targetId = std::stoi(sTid);
+
+        std::string targetName = "";
+        if (const User* u = m_userMgr.findById(targetId)) targetName = u->getUsername();
+
+        if (!targetName.empty()) {
+            int myRole = m_groupMgr.getUserRole(gid, clientName);
+            int targetRole = m_groupMgr.getUserRole(gid, targetName);
+
+            if (myRole > targetRole) {
+                m_groupMgr.leaveGroup(gid, targetName);
+
+                if (SessionPtr target = m_sessions.findById(targetId)) {
+                    std::string kickCmd = "CMD:KICKED_FROM_GROUP|" + sGid + "\n";
+                    target->send(kickCmd);
+                    std::string list = m_groupMgr.getMyGroupListCmd(targetName) + "\n";
+                    target->send(list);
+                    std::string notice = "[System] You have been kicked from Group " + std::to_string(gid) + "\n";
+                    target->send(notice);
                 }
-                else {
-                    std::string msg = "[Error] Group not found: " + arg + "\n";
-                    send(sockClient, msg.c_str(), (int)msg.length(), 0);
+
+                std::vector<SessionPtr> viewers = m_sessions.getGroupViewers(gid);
+                if (!viewers.empty()) {
+                    NetEngine::Buffer resp = buildGroupMembersCmd(gid);
+                    for (const SessionPtr& v : viewers) v->send(resp);
                 }
-                continue;
+                logToGui("[Group] " + clientName + " kicked " + targetName + " from Group " + sGid);
             }
+        }
+        return;
+    }
 
-            if (rawMsg.find("CMD:KICK_MEMBER|") == 0) {
-                std::string body = rawMsg.substr(16);
-                std::stringstream ss(body);
-                std::string sGid, sTid;
-                std::getline(ss, sGid, '|'); std::getline(ss, sTid, '|');
-                int gid = std::stoi(sGid);
-                int targetId = std::stoi(sTid);
+    if (rawMsg.find("CMD:SET_ROLE|") == 0) {
+        std::string body = rawMsg.substr(13);
+        std::stringstream ss(body);
+        std::string sGid, sTid, sRole;
+        std::getline(ss, sGid, '|'); std::getline(ss, sTid, '|'); std::getline(ss, sRole, '|');
+        int gid = std::stoi(sGid);
+        int targetId = std::stoi(sTid);
+        int newRole = std::stoi(sRole);
 
-                std::string targetName = "";
-                auto users = server->m_userMgr.getAllUsers();
-                for (auto& u : users) if (u.getId() == targetId) targetName = u.getUsername();
-
-                if (!targetName.empty()) {
-                    int myRole = server->m_groupMgr.getUserRole(gid, clientName);
-                    int targetRole = server->m_groupMgr.getUserRole(gid, targetName);
-
-                    if (myRole > targetRole) {
-                        server->m_groupMgr.leaveGroup(gid, targetName);
-                        server->m_groupMgr.save();
-                        std::lock_guard<std::mutex> lock(server->m_userMutex);
-
-                        if (server->m_onlineUsers.count(targetName)) {
-                            SOCKET targetSock = server->m_onlineUsers[targetName];
-                            std::string kickCmd = "CMD:KICKED_FROM_GROUP|" + sGid + "\n";
-                            send(targetSock, kickCmd.c_str(), (int)kickCmd.length(), 0);
-                            std::string list = server->m_groupMgr.getMyGroupListCmd(targetName) + "\n";
-                            send(targetSock, list.c_str(), (int)list.length(), 0);
-                            std::string notice = "[System] You have been kicked from Group " + std::to_string(gid) + "\n";
-                            send(targetSock, notice.c_str(), (int)notice.length(), 0);
-                        }
-
-                        for (auto const& [uName, uSock] : server->m_onlineUsers) {
-                            if (server->getClientGroupState(uSock) == gid) {
-                                std::vector<std::string> members = server->m_groupMgr.getGroupMembers(gid);
-                                std::string resp = "CMD:GROUP_MEMBERS|";
-                                for (const auto& memName : members) {
-                                    int memId = 0;
-                                    for (auto& u : users) { if (u.getUsername() == memName) { memId = u.getId(); break; } }
-                                    int status = (server->m_onlineUsers.count(memName) > 0) ? 1 : 0;
-                                    int role = server->m_groupMgr.getUserRole(gid, memName);
-                                    if (memId != 0) resp += std::to_string(memId) + "," + memName + "," + std::to_string(status) + "," + std::to_string(role) + ";";
-                                }
-                                resp += "\n";
-                                send(uSock, resp.c_str(), (int)resp.length(), 0);
-                            }
-                        }
-                        server->logToGui("[Group] " + clientName + " kicked " + targetName + " from Group " + sGid);
-                    }
+        std::string targetName = "";
+        if (const User* u = m_userMgr.findById(targetId)) targetName = u->getUsername();
+
+        if (!targetName.empty()) {
+            if (m_groupMgr.checkPermission(gid, clientName, ROLE_OWNER)) {
+                m_groupMgr.setUserRole(gid, targetName, (GroupRole)newRole);
+                std::vector<SessionPtr> viewers = m_sessions.getGroupViewers(gid);
+                if (!viewers.empty()) {
+                    NetEngine::Buffer resp = buildGroupMembersCmd(gid);
+                    for (const SessionPtr& v : viewers) v->send(resp);
                 }
-                continue;
+                logToGui("[Group] " + clientName + " set role " + sRole + " for " + targetName);
             }
+        }
+        return;
+    }
 
-            if (rawMsg.find("CMD:SET_ROLE|") == 0) {
-                std::string body = rawMsg.substr(13);
-                std::stringstream ss(body);
-                std::string sGid, sTid, sRole;
-                std::getline(ss, sGid, '|'); std::getline(ss, sTid, '|'); std::getline(ss, sRole, '|');
-                int gid = std::stoi(sGid);
-                int targetId = std::stoi(sTid);
-                int newRole = std::stoi(sRole);
+    if (rawMsg == "CMD:ENTER_REQUEST_LIST") {
+        session->setViewingRequests(true);
+        std::string resp = loadRequestsForUser(clientId, clientName);
+        session->send(resp);
+        return;
+    }
 
-                std::string targetName = "";
-                auto users = server->m_userMgr.getAllUsers();
-                for (auto& u : users) if (u.getId() == targetId) targetName = u.getUsername();
-
-                if (!targetName.empty()) {
-                    if (server->m_groupMgr.checkPermission(gid, clientName, ROLE_OWNER)) {
-                        server->m_groupMgr.setUserRole(gid, targetName, (GroupRole)newRole);
-                        server->m_groupMgr.save();
-                        std::lock_guard<std::mutex> lock(server->m_userMutex);
-                        for (auto const& [uName, uSock] : server->m_onlineUsers) {
-                            if (server->getClientGroupState(uSock) == gid) {
-                                std::vector<std::string> members = server->m_groupMgr.getGroupMembers(gid);
-                                std::string resp = "CMD:GROUP_MEMBERS|";
-                                for (const auto& memName : members) {
-                                    int memId = 0;
-                                    for (auto& u : users) { if (u.getUsername() == memName) { memId = u.getId(); break; } }
-                                    int status = (server->m_onlineUsers.count(memName) > 0) ? 1 : 0;
-                                    int role = server->m_groupMgr.getUserRole(gid, memName);
-                                    if (memId != 0) resp += std::to_string(memId) + "," + memName + "," + std::to_string(status) + "," + std::to_string(role) + ";";
-                                }
-                                resp += "\n";
-                                send(uSock, resp.c_str(), (int)resp.length(), 0);
-                            }
-                        }
-                        server->logToGui("[Group] " + clientName + " set role " + sRole + " for " + targetName);
-                    }
-                }
-                continue;
-            }
+    if (rawMsg == "CMD:LEAVE_REQUEST_LIST") {
+        session->setViewingRequests(false);
+        return;
+    }
 
-            if (rawMsg == "CMD:ENTER_REQUEST_LIST") {
-                std::lock_guard<std::mutex> lock(server->m_viewingReqMutex);
-                server->m_viewingRequestSockets.insert(sockClient);
-                std::string resp = server->loadRequestsForUser(clientId, clientName);
-                send(sockClient, resp.c_str(), (int)resp.length(), 0);
-                continue;
-            }
+    if (rawMsg.find("CMD:DECISION_REQUEST|") == 0) {
+        std::string body = rawMsg.substr(21);
+        // 【修改】客户端已在本地移除这一条，列表变化由 REQUEST_REMOVED 增量同步，不再整表重发
+        handleRequestDecision(body);
+        return;
+    }
 
-            if (rawMsg == "CMD:LEAVE_REQUEST_LIST") {
-                std::lock_guard<std::mutex> lock(server->m_viewingReqMutex);
-                server->m_viewingRequestSockets.erase(sockClient);
-                continue;
+    if (rawMsg[0] == '/') {
+        if (AdminManager::processClientCommand(
+            clientName, rawMsg, session,
+            m_sessions, m_groupMgr, m_userMgr))
+        {
+            logToGui("[" + clientName + "] Cmd: " + rawMsg);
+            if (rawMsg.find("/g_create") == 0) {
+                std::string list = m_groupMgr.getMyGroupListCmd(clientName) + "\n";
+                session->send(list);
             }
+            return;
+        }
+    }
 
-            if (rawMsg.find("CMD:DECISION_REQUEST|") == 0) {
-                std::string body = rawMsg.substr(21);
-                server->handleRequestDecision(body);
-                std::string resp = server->loadRequestsForUser(clientId, clientName);
-                send(sockClient, resp.c_str(), (int)resp.length(), 0);
-                continue;
-            }
+    if (rawMsg == "CMD:REQ_FRIEND_LIST") {
+        std::string friendList = getFriendsListCmd(clientId);
+        session->send(friendList);
+        return;
+    }
 
-            if (rawMsg[0] == '/') {
-                if (AdminManager::processClientCommand(
-                    clientName, rawMsg, sockClient,
-                    server->m_onlineUsers, server->m_userMutex, server->m_groupMgr,
-                    server->m_userMgr))
-                {
-                    server->logToGui("[" + clientName + "] Cmd: " + rawMsg);
-                    if (rawMsg.find("/g_create") == 0) {
-                        std::string list = server->m_groupMgr.getMyGroupListCmd(clientName) + "\n";
-                        send(sockClient, list.c_str(), (int)list.length(), 0);
-                    }
-                    continue;
-                }
-            }
+    if (rawMsg == "CMD:REQ_GROUP_LIST") {
+        std::string groupList = m_groupMgr.getMyGroupListCmd(clientName);
+        groupList += "\n";
+        session->send(groupList);
+        return;
+    }
 
-            if (rawMsg == "CMD:REQ_FRIEND_LIST") {
-                std::string friendList = server->getFriendsListCmd(clientId);
-                send(sockClient, friendList.c_str(), (int)friendList.length(), 0);
-                continue;
-            }
+    if (rawMsg.find("CMD:REQ_GROUP_MEMBERS|") == 0) {
+        std::string gidStr = rawMsg.substr(22);
+        int gid = std::stoi(gidStr);
+        session->send(buildGroupMembersCmd(gid));
+        return;
+    }
 
-            if (rawMsg == "CMD:REQ_GROUP_LIST") {
-                std::string groupList = server->m_groupMgr.getMyGroupListCmd(clientName);
-                groupList += "\n";
-                send(sockClient, groupList.c_str(), (int)groupList.length(), 0);
-                continue;
-            }
+    if (rawMsg.find("CMD:ENTER_FRIEND|") == 0) {
+        std::string sId = rawMsg.substr(17);
+        int targetId = std::stoi(sId);
+        session->setViewingFriend(targetId);
+        logToGui(clientName + " entered friend chat with ID " + sId);
+        // 【修改】只发最新一页，更早的由客户端滚动到顶部时用 CMD:HISTORY 取
+        sendHistoryPage(session, 0, targetId, 0, kHistoryPageSize);
+        return;
+    }
 
-            if (rawMsg.find("CMD:REQ_GROUP_MEMBERS|") == 0) {
-                std::string gidStr = rawMsg.substr(22);
-                int gid = std::stoi(gidStr);
-                std::vector<std::string> members = server->m_groupMgr.getGroupMembers(gid);
-                std::string resp = "CMD:GROUP_MEMBERS|";
-                std::lock_guard<std::mutex> lock(server->m_userMutex);
-                std::vector<User> all = server->m_userMgr.getAllUsers();
-                for (const auto& memName : members) {
-                    int memId = 0;
-                    for (auto& u : all) { if (u.getUsername() == memName) { memId = u.getId(); break; } }
-                    int status = (server->m_onlineUsers.count(memName) > 0) ? 1 : 0;
-                    int role = server->m_groupMgr.getUserRole(gid, memName);
-                    if (memId != 0) resp += std::to_string(memId) + "," + memName + "," + std::to_string(status) + "," + std::to_string(role) + ";";
-                }
-                resp += "\n";
-                send(sockClient, resp.c_str(), (int)resp.length(), 0);
-                continue;
-            }
+    if (rawMsg.find("CMD:LEAVE_FRIEND") == 0) {
+        session->setViewingFriend(-1);
+        return;
+    }
 
-            if (rawMsg.find("CMD:ENTER_FRIEND|") == 0) {
-                std::string sId = rawMsg.substr(17);
-                int targetId = std::stoi(sId);
-                server->setClientFriendState(sockClient, targetId);
-                server->logToGui(clientName + " entered friend chat with ID " + sId);
-                std::vector<std::string> history = server->loadFriendHistory(clientId, targetId, clientId);
-                for (const auto& line : history) {
-                    std::stringstream ss(line);
-                    std::string item;
-                    std::vector<std::string> parts;
-                    while (std::getline(ss, item, '|')) parts.push_back(item);
-
-                    if (parts.size() >= 5) {
-                        std::string packet = "MSG:" + std::to_string(targetId) + "|" + parts[2] + "|" + parts[3] + "|0|" + parts[0] + "|" + parts[1] + "|" + parts[4] + "\n";
-                        send(sockClient, packet.c_str(), (int)packet.length(), 0);
-                    }
-                }
-                continue;
-            }
+    if (rawMsg.find("CMD:ENTER_GROUP|") == 0) {
+        std::string sId = rawMsg.substr(16);
+        int gid = std::stoi(sId);
+        m_sessions.setViewingGroup(session, gid);
+        logToGui(clientName + " entered group " + sId);
+        sendHistoryPage(session, 1, gid, 0, kHistoryPageSize);
+        return;
+    }
 
-            if (rawMsg.find("CMD:LEAVE_FRIEND") == 0) {
-                server->setClientFriendState(sockClient, -1);
-                continue;
-            }
+    // 【新增】翻页：CMD:HISTORY|类型|会话ID|beforeId|条数
+    if (rawMsg.find("CMD:HISTORY|") == 0) {
+        std::stringstream ss(rawMsg.substr(12));
+        std::string seg;
+        std::vector<std::string> parts;
+        while (std::getline(ss, seg, '|')) parts.push_back(seg);
+        MessageId beforeId = 0;
+        if (parts.size() >= 4 && MessageIdGenerator::parse(parts[2], beforeId) && beforeId != 0) {
+            int type = atoi(parts[0].c_str()) == 1 ? 1 : 0;
+            int limit = atoi(parts[3].c_str());
+            sendHistoryPage(session, type, atoi(parts[1].c_str()), beforeId, limit > 0 ? (size_t)limit : kHistoryPageSize);
+        }
+        return;
+    }
 
-            if (rawMsg.find("CMD:ENTER_GROUP|") == 0) {
-                std::string sId = rawMsg.substr(16);
-                int gid = std::stoi(sId);
-                server->setClientGroupState(sockClient, gid);
-                server->logToGui(clientName + " entered group " + sId);
-                std::string gName = server->m_groupMgr.getGroupName(gid);
-                if (gName != "Unknown") {
-                    std::vector<std::string> history = server->loadGroupHistory(gName, clientId);
-                    for (const auto& line : history) {
-                        std::stringstream ss(line);
-                        std::string item;
-                        std::vector<std::string> parts;
-                        while (std::getline(ss, item, '|')) parts.push_back(item);
-
-                        if (parts.size() >= 5) {
-                            std::string packet = "MSG:" + std::to_string(gid) + "|" + parts[2] + "|" + parts[3] + "|1|" + parts[0] + "|" + parts[1] + "|" + parts[4] + "\n";
-                            send(sockClient, packet.c_str(), (int)packet.length(), 0);
-                        }
-                    }
-                }
-                continue;
-            }
+    if (rawMsg.find("CMD:LEAVE_GROUP") == 0) {
+        m_sessions.setViewingGroup(session, -1);
+        return;
+    }
 
-            if (rawMsg.find("CMD:LEAVE_GROUP") == 0) {
-                server->setClientGroupState(sockClient, -1);
-                continue;
+    if (rawMsg.find("SEND:") == 0) {
+        std::string body = rawMsg.substr(5);
+        std::stringstream ss(body);
+        std::string seg;
+        std::vector<std::string> parts;
+        while (std::getline(ss, seg, '|')) parts.push_back(seg);
+
+        if (parts.size() >= 3) {
+            int type = std::stoi(parts[0]);
+            int targetId = std::stoi(parts[1]);
+            std::string content = parts[2];
+            std::string timeStr = getCurrentTimeStr();
+
+            // 【核心】增加成员检查逻辑
+            if (type == 1) { // 群聊
+                if (!m_groupMgr.isMember(targetId, clientName)) {
+                    // 不在群里，发送错误提示
+                    std::string errorMsg = "[System] Failed to send: You are not a member of this group.\n";
+                    session->send(errorMsg);
+
+                    /* 强制客户端退出界面
+                    std::string kickCmd = "CMD:KICKED_FROM_GROUP|" + std::to_string(targetId) + "\n";
+                    session->send(kickCmd);*/
+
+                    return; // 跳过后续保存和转发
+                }
             }
 
-            if (rawMsg.find("SEND:") == 0) {
-                std::string body = rawMsg.substr(5);
-                std::stringstream ss(body);
-                std::string seg;
-                std::vector<std::string> parts;
-                while (std::getline(ss, seg, '|')) parts.push_back(seg);
-
-                if (parts.size() >= 3) {
-                    int type = std::stoi(parts[0]);
-                    int targetId = std::stoi(parts[1]);
-                    std::string content = parts[2];
-                    std::string timeStr = getCurrentTimeStr();
-
-                    std::string uuid = generateUUID();
-
-                    // 【核心】增加成员检查逻辑
-                    if (type == 1) { // 群聊
-                        std::vector<std::string> members = server->m_groupMgr.getGroupMembers(targetId);
-                        bool isMember = false;
-                        for (const auto& m : members) {
-                            if (m == clientName) {
-                                isMember = true;
-                                break;
-                            }
-                        }
-
-                        if (!isMember) {
-                            // 不在群里，发送错误提示
-                            std::string errorMsg = "[System] Failed to send: You are not a member of this group.\n";
-                            send(sockClient, errorMsg.c_str(), (int)errorMsg.length(), 0);
-
-                            /* 强制客户端退出界面
-                            std::string kickCmd = "CMD:KICKED_FROM_GROUP|" + std::to_string(targetId) + "\n";
-                            send(sockClient, kickCmd.c_str(), (int)kickCmd.length(), 0);*/
-
-                            continue; // 跳过后续保存和转发
-                        }
-                    }
-
-                    if (type == 0) { // 私聊
-                        std::string targetName = "";
-                        std::vector<User> all = server->m_userMgr.getAllUsers();
-                        for (auto& u : all) if (u.getId() == targetId) { targetName = u.getUsername(); break; }
-                        server->saveFriendMessageToFile(clientId, targetId, clientId, clientName, content, timeStr);
-                        if (!targetName.empty()) {
-                            std::lock_guard<std::mutex> lock(server->m_userMutex);
-                            if (server->m_onlineUsers.count(targetName)) {
-                                std::string packetToTarget = "MSG:" + std::to_string(clientId) + "|" + clientName + "|" + content + "|0|" + timeStr + "|" + std::to_string(clientId) + "|" + uuid + "\n";
-                                send(server->m_onlineUsers[targetName], packetToTarget.c_str(), (int)packetToTarget.length(), 0);
-                            }
-                        }
-                        std::string packetToMe = "MSG:" + std::to_string(targetId) + "|" + clientName + "|" + content + "|0|" + timeStr + "|" + std::to_string(clientId) + "|" + uuid + "\n";
-                        send(sockClient, packetToMe.c_str(), (int)packetToMe.length(), 0);
-                        server->logToGui("[Chat] " + clientName + " -> " + (targetName.empty() ? "Offline" : targetName) + ": " + content);
-                    }
-                    else if (type == 1) { // 群聊 (验证通过)
-                        std::string gName = server->m_groupMgr.getGroupName(targetId);
-                        server->saveGroupMessageToFile(gName, clientId, clientName, content, timeStr);
-                        std::string packet = "MSG:" + std::to_string(targetId) + "|" + clientName + "|" + content + "|1|" + timeStr + "|" + std::to_string(clientId) + "|" + uuid + "\n";
-                        std::lock_guard<std::mutex> lock(server->m_userMutex);
-                        for (auto const& [uName, uSock] : server->m_onlineUsers) {
-                            if (server->getClientGroupState(uSock) == targetId) {
-                                send(uSock, packet.c_str(), (int)packet.length(), 0);
-                            }
-                        }
-                        server->logToGui("[Group " + std::to_string(targetId) + "] " + clientName + ": " + content);
-                    }
+            if (type == 0) { // 私聊
+                std::string targetName = "";
+                if (const User* u = m_userMgr.findById(targetId)) targetName = u->getUsername();
+                MessageId msgId = saveFriendMessageToFile(clientId, targetId, clientId, clientName, content, timeStr);
+                std::string uuid = MessageIdGenerator::toString(msgId);
+                if (SessionPtr target = m_sessions.findById(targetId)) {
+                    std::string packetToTarget = "MSG:" + std::to_string(clientId) + "|" + clientName + "|" + content + "|0|" + timeStr + "|" + std::to_string(clientId) + "|" + uuid + "\n";
+                    target->send(packetToTarget);
+                }
+                std::string packetToMe = "MSG:" + std::to_string(targetId) + "|" + clientName + "|" + content + "|0|" + timeStr + "|" + std::to_string(clientId) + "|" + uuid + "\n";
+                session->send(packetToMe);
+                if (m_log.isEnabled(LogWriter::LEVEL_CHAT)) {
+                    logToGui("[Chat] " + clientName + " -> " + (targetName.empty() ? "Offline" : targetName) + ": " + content, LogWriter::LEVEL_CHAT);
                 }
-                continue;
             }
-
-            std::string fullMsg = "[" + clientName + "]: " + rawMsg;
-            server->logToGui(fullMsg);
-            {
-                std::lock_guard<std::mutex> lock(server->m_userMutex);
-                for (auto& pair : server->m_onlineUsers) {
-                    send(pair.second, fullMsg.c_str(), (int)fullMsg.length(), 0);
+            else if (type == 1) { // 群聊 (验证通过)
+                std::string gName = m_groupMgr.getGroupName(targetId);
+                MessageId msgId = saveGroupMessageToFile(gName, clientId, clientName, content, timeStr);
+                std::string uuid = MessageIdGenerator::toString(msgId);
+                NetEngine::Buffer packet = NetEngine::makeBuffer("MSG:" + std::to_string(targetId) + "|" + clientName + "|" + content + "|1|" + timeStr + "|" + std::to_string(clientId) + "|" + uuid + "\n");
+                for (const SessionPtr& v : m_sessions.getGroupViewers(targetId)) {
+                    v->send(packet, NetEngine::SEND_DROPPABLE);
+                }
+                if (m_log.isEnabled(LogWriter::LEVEL_CHAT)) {
+                    logToGui("[Group " + std::to_string(targetId) + "] " + clientName + ": " + content, LogWriter::LEVEL_CHAT);
                 }
             }
         }
-        else {
-            server->logToGui("User [" + clientName + "] disconnected.");
-            break;
-        }
-    }
-
-    {
-        std::lock_guard<std::mutex> lock(server->m_userMutex);
-        server->m_onlineUsers.erase(clientName);
-    }
-    server->setClientGroupState(sockClient, -1);
-    server->setClientFriendState(sockClient, -1);
-    {
-        std::lock_guard<std::mutex> lock(server->m_viewingReqMutex);
-        server->m_viewingRequestSockets.erase(sockClient);
+        return;
     }
-    server->broadcastStatusChange(clientId, clientName, 0);
 
-    std::string newUserList = server->buildUserList();
-    {
-        std::lock_guard<std::mutex> lock(server->m_userMutex);
-        for (auto const& [name, sock] : server->m_onlineUsers) {
-            send(sock, newUserList.c_str(), (int)newUserList.length(), 0);
-        }
+    std::string fullMsg = "[" + clientName + "]: " + rawMsg;
+    logToGui(fullMsg, LogWriter::LEVEL_CHAT);
+    NetEngine::Buffer packet = NetEngine::makeBuffer(fullMsg + "\n");
+    for (const SessionPtr& s : m_sessions.getOnlineSessions()) {
+        s->send(packet, NetEngine::SEND_DROPPABLE);
     }
-
-    closesocket(sockClient);
-    delete info;
-    return 0;
 }
 
 void ServerThread::executeConsoleCommand(QString cmd) {
@@ -1121,12 +856,11 @@ void ServerThread::executeConsoleCommand(QString cmd) {
         else {
             AdminManager::setUserGroup(arg1, GROUP_ADMIN);
             logToGui("[System] Success: User [" + arg1 + "] is now an Admin.");
-            std::lock_guard<std::mutex> lock(m_userMutex);
-            if (m_onlineUsers.count(arg1)) {
+            if (SessionPtr target = m_sessions.findByName(arg1)) {
                 std::string grantMsg = "CMD:GRANT_ADMIN\n";
-                send(m_onlineUsers[arg1], grantMsg.c_str(), (int)grantMsg.length(), 0);
+                target->send(grantMsg);
                 std::string notice = "[System] Server console granted you Admin permissions.\n";
-                send(m_onlineUsers[arg1], notice.c_str(), (int)notice.length(), 0);
+                target->send(notice);
             }
         }
     }
@@ -1137,12 +871,11 @@ void ServerThread::executeConsoleCommand(QString cmd) {
         else {
             AdminManager::setUserGroup(arg1, GROUP_USER);
             logToGui("[System] Success: User [" + arg1 + "] is no longer an Admin.");
-            std::lock_guard<std::mutex> lock(m_userMutex);
-            if (m_onlineUsers.count(arg1)) {
+            if (SessionPtr target = m_sessions.findByName(arg1)) {
                 std::string revokeMsg = "CMD:REVOKE_ADMIN\n";
-                send(m_onlineUsers[arg1], revokeMsg.c_str(), (int)revokeMsg.length(), 0);
+                target->send(revokeMsg);
                 std::string notice = "[System] Your Admin permissions have been revoked by Server Console.\n";
-                send(m_onlineUsers[arg1], notice.c_str(), (int)notice.length(), 0);
+                target->send(notice);
             }
         }
     }
@@ -1151,13 +884,11 @@ void ServerThread::executeConsoleCommand(QString cmd) {
             logToGui("[Error] Usage: kick <username>");
         }
         else {
-            std::lock_guard<std::mutex> lock(m_userMutex);
-            if (m_onlineUsers.count(arg1)) {
-                SOCKET s = m_onlineUsers[arg1];
+            if (SessionPtr target = m_sessions.findByName(arg1)) {
                 std::string notice = "[System] You have been kicked by Server Console.\n";
-                send(s, notice.c_str(), (int)notice.length(), 0);
-                closesocket(s);
-                m_onlineUsers.erase(arg1);
+                target->send(notice);
+                // 会话在所属 I/O 线程回收连接时移除
+                target->close();
                 logToGui("[System] User [" + arg1 + "] has been kicked.");
             }
             else {
@@ -1166,25 +897,23 @@ void ServerThread::executeConsoleCommand(QString cmd) {
         }
     }
     else if (command == "/who") {
-        std::lock_guard<std::mutex> lock(m_userMutex);
-        QString listMsg = "--- Online Users (" + QString::number(m_onlineUsers.size()) + ") ---\n";
-        for (auto& pair : m_onlineUsers) {
-            std::string role = AdminManager::getUserGroup(pair.first);
-            listMsg += " * " + QString::fromStdString(pair.first) + " [" + QString::fromStdString(role) + "]\n";
+        std::vector<SessionPtr> online = m_sessions.getOnlineSessions();
+        std::string listMsg = "--- Online Users (" + std::to_string(online.size()) + ") ---\n";
+        for (const SessionPtr& s : online) {
+            std::string role = AdminManager::getUserGroup(s->getName());
+            listMsg += " * " + s->getName() + " [" + role + "] frames: " + std::to_string(s->getFramesIn())
+                + ", queued: " + std::to_string(s->getQueueStat().queuedBytes) + "\n";
         }
-        emit logMessage(listMsg);
+        m_feed.push(listMsg);
     }
     else if (command == "/all") {
         std::string content;
         size_t pos = strMsg.find(' ');
         if (pos != std::string::npos) content = strMsg.substr(pos + 1);
         if (!content.empty()) {
-            std::string broadcastMsg = "\n[Server Console]: " + content + "\n";
-            {
-                std::lock_guard<std::mutex> lock(m_userMutex);
-                for (auto& pair : m_onlineUsers) {
-                    send(pair.second, broadcastMsg.c_str(), (int)broadcastMsg.length(), 0);
-                }
+            NetEngine::Buffer broadcastMsg = NetEngine::makeBuffer("\n[Server Console]: " + content + "\n");
+            for (const SessionPtr& s : m_sessions.getOnlineSessions()) {
+                s->send(broadcastMsg);
             }
             logToGui("[Broadcast] " + content);
         }
@@ -1197,7 +926,6 @@ void ServerThread::executeConsoleCommand(QString cmd) {
             std::string owner = arg2.empty() ? "ServerConsole" : arg2;
             int gid = m_groupMgr.createGroup(arg1, owner);
             if (gid != -1) {
-                m_groupMgr.save();
                 logToGui("[System] Group [" + arg1 + "] created. ID: " + std::to_string(gid));
             }
             else {
@@ -1205,6 +933,90 @@ void ServerThread::executeConsoleCommand(QString cmd) {
             }
         }
     }
+    else if (command == "/stats") {
+        std::vector<NetEngine::QueueStat> queues = m_engine.queueStats();
+        size_t queuedTotal = 0;
+        int slowCount = 0;
+        for (const auto& q : queues) {
+            queuedTotal += q.queuedBytes;
+            if (q.slow) slowCount++;
+        }
+        uint64_t fileHits = m_files.getHits();
+        uint64_t fileMisses = m_files.getMisses();
+        std::string statsMsg =
+            "--- Server Stats ---\n"
+            " Connections     : " + std::to_string(m_engine.connectionCount()) + "\n"
+            " Online users    : " + std::to_string(m_sessions.getOnlineCount()) + "\n"
+            " I/O threads     : " + std::to_string(m_engine.ioThreadCount()) + "\n"
+            " Queued bytes    : " + std::to_string(queuedTotal) + "\n"
+            " Slow sessions   : " + std::to_string(slowCount) + "\n"
+            " Dropped msgs    : " + std::to_string(m_engine.droppedMessages()) + "\n"
+            " Slow disconnects: " + std::to_string(m_engine.slowDisconnects()) + "\n"
+            " GUI log dropped : " + std::to_string(m_feed.droppedTotal()) + "\n"
+            " Pending requests: " + std::to_string(m_requests.getPendingCount()) + "\n"
+            " Tombstones      : " + std::to_string(m_history.getPendingTombstones()) + " pending\n"
+            " Roster cache    : " + std::to_string(m_rosters.getHits()) + " hits / "
+                + std::to_string(m_rosters.getMisses()) + " misses, "
+                + std::to_string(m_rosters.getPatches()) + " presence patches, "
+                + std::to_string(m_rosters.getGroupCount()) + " groups\n"
+            " History cache   : " + std::to_string(m_history.cache().getHits()) + " hits / "
+                + std::to_string(m_history.cache().getMisses()) + " misses, "
+                + std::to_string(m_history.cache().getConversationCount()) + " conversations, "
+                + std::to_string(m_history.cache().getBytes() / 1024) + " KB\n"
+            " History writer  : " + std::string(HistoryWriter::durabilityName(m_writer.durability()))
+                + (m_writer.durability() == HistoryWriter::DURABILITY_BATCHED ? " (" + std::to_string(m_writer.syncIntervalMs()) + " ms)" : "")
+                + ", " + std::to_string(m_writer.getPending()) + " queued, "
+                + std::to_string(m_writer.getBatches()) + " batches, "
+                + std::to_string(m_writer.getSyncs()) + " syncs, "
+                + std::to_string(m_writer.getFailures()) + " failed\n"
+            " File handles    : " + std::to_string(m_files.getOpenCount()) + "/" + std::to_string(m_files.getCapacity()) + " open, "
+                + std::to_string(fileHits) + " hits / " + std::to_string(fileMisses) + " misses ("
+                + std::to_string(fileHits + fileMisses == 0 ? 0 : fileHits * 100 / (fileHits + fileMisses)) + "%), "
+                + std::to_string(m_files.getEvictions()) + " evicted\n";
+        logToGui(statsMsg);
+    }
+    else if (command == "/queues") {
+        size_t limit = 20;
+        if (!arg1.empty()) limit = (size_t)std::max(1, atoi(arg1.c_str()));
+
+        std::vector<NetEngine::QueueStat> queues = m_engine.queueStats();
+        std::sort(queues.begin(), queues.end(), [](const NetEngine::QueueStat& a, const NetEngine::QueueStat& b) {
+            return a.queuedBytes > b.queuedBytes;
+        });
+        if (queues.size() > limit) queues.resize(limit);
+
+        std::string listMsg = "--- Outbound Queues (queued / peak / dropped) ---\n";
+        for (const auto& q : queues) {
+            std::string name = "<login>";
+            SessionPtr s = m_sessions.findBySocket(q.sock);
+            if (s && s->isLoggedIn()) name = s->getName();
+            listMsg += " * " + name + " : " + std::to_string(q.queuedBytes) + " / " + std::to_string(q.peakBytes)
+                + " / " + std::to_string(q.dropped) + (q.slow ? " [SLOW]" : "") + "\n";
+        }
+        logToGui(listMsg);
+    }
+    else if (command == "/loglevel") {
+        LogWriter::Level level;
+        if (arg1.empty()) {
+            logToGui(std::string("[System] Log level: ") + LogWriter::levelName(m_log.level())
+                + ", dropped: " + std::to_string(m_log.droppedCount()), LogWriter::LEVEL_ERROR);
+        }
+        else if (LogWriter::parseLevel(arg1, level)) {
+            m_log.setLevel(level);
+            logToGui(std::string("[System] Log level set to ") + LogWriter::levelName(level), LogWriter::LEVEL_ERROR);
+        }
+        else {
+            logToGui("[Error] Usage: /loglevel [debug|chat|info|warn|error]", LogWriter::LEVEL_ERROR);
+        }
+    }
+    else if (command == "/tail") {
+        size_t count = 50;
+        if (!arg1.empty()) count = (size_t)std::max(1, atoi(arg1.c_str()));
+        // 直接显示，不再写回日志
+        std::string tailMsg = "--- Recent Log ---\n";
+        for (const auto& line : m_log.tail(count)) tailMsg += line + "\n";
+        m_feed.push(tailMsg);
+    }
     else if (command == "/help") {
         std::string helpMsg =
             "--- Server Console Help ---\n"
@@ -1213,6 +1025,10 @@ void ServerThread::executeConsoleCommand(QString cmd) {
             " /kick <User>    - Kick User\n"
             " /who            - List Users\n"
             " /all <Msg>      - Broadcast\n"
+            " /stats          - Server Stats\n"
+            " /queues [N]     - Slowest Outbound Queues\n"
+            " /loglevel [L]   - debug|chat|info|warn|error\n"
+            " /tail [N]       - Recent Log Lines\n"
             " /create_group <Name>\n";
         logToGui(helpMsg);
     }
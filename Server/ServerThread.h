@@ -10,9 +10,20 @@
 #include "DataManager.h"
 #include "op.h"
 #include "Group.h"
+#include "NetEngine.h"
+#include "LogWriter.h"
+#include "LogFeed.h"
+#include "Session.h"
+#include "MessageId.h"
+#include "HistoryStore.h"
+#include "HistoryWriter.h"
+#include "FileHandleCache.h"
+#include "FriendGraph.h"
+#include "RequestStore.h"
+#include "RosterCache.h"
 #pragma comment(lib,"ws2_32.lib")
 
-class ServerThread : public QThread
+class ServerThread : public QThread, public NetEngine::Handler
 {
     Q_OBJECT
 
@@ -21,76 +32,79 @@ public:
     ~ServerThread();
 
     void setPort(int port);
+    // 【新增】聊天记录落盘方式，启动参数 --durability / --fsync-interval
+    void setDurability(HistoryWriter::Durability mode, int syncIntervalMs);
     void executeConsoleCommand(QString cmd);
 
+    // 【修改】界面日志不再逐行发信号，由窗口定时从这里批量取
+    LogFeed* logFeed() { return &m_feed; }
+
 protected:
     void run() override;
 
-signals:
-    void logMessage(QString msg);
+    // NetEngine::Handler：在 I/O 线程中被调用
+    void onConnect(SOCKET s) override;
+    void onFrame(SOCKET s, const std::string& frame) override;
+    void onDisconnect(SOCKET s) override;
 
 private:
     GroupManager m_groupMgr;
     int m_port = 9870;
     SOCKET m_serverSock;
     bool m_isRunning;
+    NetEngine m_engine;
+    // 【修改】在线用户、查看状态、请求列表订阅统一收进 Session，按 socket/ID/用户名 一次查到
+    SessionManager m_sessions;
 
     DataManager m_userMgr;
-    DataManager m_logMgr;
-    std::map<std::string, SOCKET> m_onlineUsers;
-    std::mutex m_userMutex;
-    std::mutex m_logMutex;
-
-    std::map<SOCKET, int> m_clientGroupMap;
-    std::mutex m_groupStateMutex;
-    std::map<SOCKET, int> m_clientFriendMap;
-    std::mutex m_friendStateMutex;
-
-    std::string m_requestFile = "Request.txt";
-    std::mutex m_requestMutex;
-    std::set<SOCKET> m_viewingRequestSockets;
-    std::mutex m_viewingReqMutex;
+    FriendGraph m_friends;  // 【新增】好友关系索引，取代扫描 FriendRecord 目录
+    LogWriter m_log;        // 【修改】异步滚动日志，取代整表重写的 DataManager(TYPE_LOG)
+    LogFeed m_feed;         // 【新增】待显示到界面的日志
+    MessageIdGenerator m_msgIds;    // 【新增】存储与下发共用同一个消息 ID
+    FileHandleCache m_files;        // 【新增】聊天记录与请求文件共用的追加句柄缓存
+    RequestStore m_requests;        // 【新增】待处理申请，按目标用户/群建索引，取代整文件扫描和重写
+    HistoryStore m_history;         // 【新增】分段二进制聊天记录，取代逐行解析的 .txt
+    HistoryWriter m_writer;         // 【新增】聊天记录后台写入，发送线程不再等磁盘
+    RosterCache m_rosters;          // 【新增】已序列化的群成员列表，按群版本失效
 
     void saveRequest(std::string type, int fromId, std::string fromName, int targetId);
-    void checkAndPushRequestUpdate(int targetId);
+    // 【修改】只推给受影响且正在看申请列表的人 (好友申请的目标，或该群的群主/管理员)，
+    // 内容为增量 CMD:REQUEST_ADDED|类型,申请人ID,申请人名,目标ID / CMD:REQUEST_REMOVED|类型,申请人ID,目标ID
+    void pushRequestDelta(const PendingRequest& req, bool added);
     std::string loadRequestsForUser(int userId, std::string userName);
     void handleRequestDecision(std::string decisionStr);
-    void removeRequest(std::string type, int fromId, int targetId);
 
-    void logToGui(std::string msg);
+    // 低于当前日志级别的消息既不写文件也不显示；聊天内容用 LEVEL_CHAT
+    void logToGui(std::string msg, LogWriter::Level level = LogWriter::LEVEL_INFO);
     std::string buildUserList();
 
     void initGroupRecordFolder();
-    // 【修改】增加 senderId
-    void saveGroupMessageToFile(const std::string& groupName, int senderId, const std::string& sender, const std::string& content, const std::string& time);
-    // 【修改】增加 requesterId 用于过滤
-    std::vector<std::string> loadGroupHistory(const std::string& groupName, int requesterId);
+    // 【修改】增加 senderId；入队写入并返回分配的消息 ID (下发时使用同一个)
+    MessageId saveGroupMessageToFile(const std::string& groupName, int senderId, const std::string& sender, const std::string& content, const std::string& time);
+
 
     void initFriendRecordFolder();
-    void saveFriendMessageToFile(int id1, int id2, int senderId, const std::string& senderName, const std::string& content, const std::string& time);
-    // 【修改】增加 requesterId 用于过滤
-    std::vector<std::string> loadFriendHistory(int id1, int id2, int requesterId);
+    MessageId saveFriendMessageToFile(int id1, int id2, int senderId, const std::string& senderName, const std::string& content, const std::string& time);
 
-    // 【新增】服务器端 UUID 生成
-    static std::string generateUUID();
+    // 【新增】历史记录转成下发给客户端的 MSG 包 (type: 0 私聊 / 1 群聊)
+    static std::string buildHistoryPacket(int sessionId, int type, const HistoryRecord& rec);
+    // 【新增】分页下发历史：HISTORY_BEGIN|type|sid|下一页游标，若干 MSG，HISTORY_END|type|sid
+    // beforeId 为 0 表示最新一页
+    void sendHistoryPage(const SessionPtr& session, int type, int sessionId, MessageId beforeId, size_t limit);
+    static constexpr size_t kHistoryPageSize = 50;
+    static constexpr size_t kHistoryPageMax = 200;
 
     // 【新增】处理删除消息
-    void handleDeleteMessage(SOCKET clientSock, int myId, const std::string& uuid);
-    void updateFileForDelete(const std::string& filePath, const std::string& uuid, int myId);
+    void handleDeleteMessage(const SessionPtr& session, const std::string& uuid);
 
     std::string getFriendsListCmd(int userId);
 
-    void setClientGroupState(SOCKET s, int gid);
-    int getClientGroupState(SOCKET s);
-    void setClientFriendState(SOCKET s, int fid);
-    int getClientFriendState(SOCKET s);
+    // 【修改】返回可直接共享给所有查看者的 Buffer；群版本未变时取缓存
+    NetEngine::Buffer buildGroupMembersCmd(int gid);
 
+    // 【修改】同时改写缓存的群成员列表中该用户的在线位
     void broadcastStatusChange(int userId, std::string userName, int status);
 
-    static DWORD WINAPI ClientHandlerStatic(LPVOID lpParam);
-};
-
-struct ThreadInfo {
-    SOCKET sock;
-    ServerThread* pServer;
-};
\ No newline at end of file
+    void handleLogin(const SessionPtr& session, const std::string& rawMsg);
+    void handleClientMessage(const SessionPtr& session, const std::string& rawMsg);
+};
\ No newline at end of file
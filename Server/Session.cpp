@@ -0,0 +1,137 @@
+﻿#include "Session.h"
+#include <chrono>
+
+// ====================================================================
+// Session
+// ====================================================================
+
+Session::Session(NetEngine& engine, SOCKET sock, NetEngine::ConnectionPtr conn)
+    : m_engine(engine)
+    , m_sock(sock)
+    , m_conn(std::move(conn))
+{
+    m_connectedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool Session::send(const std::string& data, NetEngine::SendPolicy policy) {
+    return m_engine.send(m_conn, NetEngine::makeBuffer(data), policy);
+}
+
+bool Session::send(const NetEngine::Buffer& data, NetEngine::SendPolicy policy) {
+    return m_engine.send(m_conn, data, policy);
+}
+
+void Session::close(bool flushFirst) {
+    m_engine.closeConnection(m_conn, flushFirst);
+}
+
+NetEngine::QueueStat Session::getQueueStat() const {
+    return m_engine.queueStat(m_conn);
+}
+
+// ====================================================================
+// SessionManager
+// ====================================================================
+
+SessionManager::SessionManager(NetEngine& engine)
+    : m_engine(engine)
+{
+}
+
+SessionPtr SessionManager::create(SOCKET s) {
+    SessionPtr session = std::make_shared<Session>(m_engine, s, m_engine.getConnection(s));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bySocket[s] = session;
+    return session;
+}
+
+SessionPtr SessionManager::remove(SOCKET s) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_bySocket.find(s);
+    if (it == m_bySocket.end()) return nullptr;
+    SessionPtr session = it->second;
+    m_bySocket.erase(it);
+
+    unindexGroupLocked(session);
+    session->m_viewingGroup = -1;
+
+    // 只有索引仍指向本会话时才移除，避免误删重复登录后的新会话
+    if (session->isLoggedIn()) {
+        auto idIt = m_byId.find(session->m_userId);
+        if (idIt != m_byId.end() && idIt->second == session) m_byId.erase(idIt);
+        auto nameIt = m_byName.find(session->m_name);
+        if (nameIt != m_byName.end() && nameIt->second == session) m_byName.erase(nameIt);
+    }
+    return session;
+}
+
+void SessionManager::bindUser(const SessionPtr& session, int userId, const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    session->m_userId = userId;
+    session->m_name = name;
+    session->m_loggedIn.store(true, std::memory_order_release);
+    m_byId[userId] = session;
+    m_byName[name] = session;
+}
+
+SessionPtr SessionManager::findBySocket(SOCKET s) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_bySocket.find(s);
+    return it == m_bySocket.end() ? nullptr : it->second;
+}
+
+SessionPtr SessionManager::findById(int userId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_byId.find(userId);
+    return it == m_byId.end() ? nullptr : it->second;
+}
+
+SessionPtr SessionManager::findByName(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_byName.find(name);
+    return it == m_byName.end() ? nullptr : it->second;
+}
+
+bool SessionManager::isOnline(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_byName.count(name) > 0;
+}
+
+std::vector<SessionPtr> SessionManager::getOnlineSessions() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<SessionPtr> sessions;
+    sessions.reserve(m_byName.size());
+    for (const auto& pair : m_byName) sessions.push_back(pair.second);
+    return sessions;
+}
+
+size_t SessionManager::getOnlineCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_byName.size();
+}
+
+// 调用方需已持有 m_mutex
+void SessionManager::unindexGroupLocked(const SessionPtr& session) {
+    auto it = m_groupViewers.find(session->m_viewingGroup);
+    if (it == m_groupViewers.end()) return;
+    it->second.erase(session);
+    if (it->second.empty()) m_groupViewers.erase(it);
+}
+
+void SessionManager::setViewingGroup(const SessionPtr& session, int gid) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (session->m_viewingGroup == gid) return;
+    unindexGroupLocked(session);
+    session->m_viewingGroup = gid;
+    // 已断开的会话不再进入索引
+    auto it = m_bySocket.find(session->m_sock);
+    if (gid > 0 && it != m_bySocket.end() && it->second == session) m_groupViewers[gid].insert(session);
+}
+
+std::vector<SessionPtr> SessionManager::getGroupViewers(int gid) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_groupViewers.find(gid);
+    if (it == m_groupViewers.end()) return {};
+    return std::vector<SessionPtr>(it->second.begin(), it->second.end());
+}
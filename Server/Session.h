@@ -0,0 +1,110 @@
+﻿#pragma once
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <winsock2.h>
+#include "NetEngine.h"
+
+// ====================================================================
+// Session：一个客户端连接的全部服务端状态
+// 身份、当前查看的会话/群、请求列表订阅、统计，以及发送用的连接句柄
+// 由 SessionManager 统一建立索引 (socket / 用户ID / 用户名 / 群查看者)
+// ====================================================================
+
+class Session {
+public:
+    Session(NetEngine& engine, SOCKET sock, NetEngine::ConnectionPtr conn);
+
+    SOCKET getSocket() const { return m_sock; }
+
+    // 身份在登录时由 SessionManager::bindUser 写入一次，之后只读
+    bool isLoggedIn() const { return m_loggedIn.load(std::memory_order_acquire); }
+    int getId() const { return m_userId; }
+    const std::string& getName() const { return m_name; }
+
+    // 直接经由连接句柄发送，不再按 socket 查表
+    bool send(const std::string& data, NetEngine::SendPolicy policy = NetEngine::SEND_RELIABLE);
+    bool send(const NetEngine::Buffer& data, NetEngine::SendPolicy policy = NetEngine::SEND_RELIABLE);
+    void close(bool flushFirst = true);
+
+    // --- 订阅状态 ---
+    // 当前查看的群 (-1 表示没有)；修改请走 SessionManager::setViewingGroup 以同步索引
+    int getViewingGroup() const { return m_viewingGroup; }
+    int getViewingFriend() const { return m_viewingFriend; }
+    void setViewingFriend(int fid) { m_viewingFriend = fid; }
+    bool isViewingRequests() const { return m_viewingRequests; }
+    void setViewingRequests(bool viewing) { m_viewingRequests = viewing; }
+
+    // --- 统计 ---
+    void countFrame() { m_framesIn.fetch_add(1, std::memory_order_relaxed); }
+    unsigned long long getFramesIn() const { return m_framesIn; }
+    long long getConnectedAt() const { return m_connectedAt; }
+    NetEngine::QueueStat getQueueStat() const;
+
+private:
+    friend class SessionManager;
+
+    NetEngine& m_engine;
+    const SOCKET m_sock;
+    NetEngine::ConnectionPtr m_conn;
+
+    int m_userId = 0;
+    std::string m_name;
+    std::atomic<bool> m_loggedIn{ false };
+
+    std::atomic<int> m_viewingGroup{ -1 };
+    std::atomic<int> m_viewingFriend{ -1 };
+    std::atomic<bool> m_viewingRequests{ false };
+
+    long long m_connectedAt;
+    std::atomic<unsigned long long> m_framesIn{ 0 };
+};
+
+typedef std::shared_ptr<Session> SessionPtr;
+
+// ====================================================================
+// SessionManager：会话表与各类索引，一把锁保护全部索引
+// 查找结果是 shared_ptr，拿到后无需持锁即可使用
+// ====================================================================
+
+class SessionManager {
+public:
+    explicit SessionManager(NetEngine& engine);
+
+    // 连接建立时创建，断开时移除 (返回被移除的会话，不存在时为空)
+    SessionPtr create(SOCKET s);
+    SessionPtr remove(SOCKET s);
+
+    // 登录成功后写入身份并加入 ID/用户名索引
+    // 同一账号重复登录时新会话顶替旧会话在索引中的位置 (旧连接仍保持，直到断开)
+    void bindUser(const SessionPtr& session, int userId, const std::string& name);
+
+    SessionPtr findBySocket(SOCKET s) const;
+    SessionPtr findById(int userId) const;
+    SessionPtr findByName(const std::string& name) const;
+    bool isOnline(const std::string& name) const;
+
+    // 已登录会话的快照，按用户名排序
+    std::vector<SessionPtr> getOnlineSessions() const;
+    size_t getOnlineCount() const;
+
+    // --- 群查看者索引：gid -> 正在查看该群的会话 ---
+    void setViewingGroup(const SessionPtr& session, int gid);
+    std::vector<SessionPtr> getGroupViewers(int gid) const;
+
+private:
+    void unindexGroupLocked(const SessionPtr& session);
+
+    NetEngine& m_engine;
+
+    std::unordered_map<SOCKET, SessionPtr> m_bySocket;          // 全部连接 (含未登录)
+    std::unordered_map<int, SessionPtr> m_byId;                 // 已登录
+    std::map<std::string, SessionPtr> m_byName;                 // 已登录，有序便于列表输出
+    std::unordered_map<int, std::set<SessionPtr>> m_groupViewers;
+    mutable std::mutex m_mutex;
+};
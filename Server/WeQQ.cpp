@@ -1,5 +1,7 @@
 ﻿#include "WeQQ.h"
 #include <QMessageBox>
+#include <QScrollBar>
+#include <QTextCursor>
 
 // =========================================
 // 1. 构造函数
@@ -12,10 +14,11 @@ WeQQ::WeQQ(QWidget* parent)
     // 初始化后台服务器线程
     m_serverThread = new ServerThread(this);
 
-    // 连接日志信号：后台发日志 -> 显示在界面 txtLog
-    connect(m_serverThread, &ServerThread::logMessage, this, [=](QString msg) {
-        ui.txtLog->append(msg);
-        });
+    // 【修改】日志按固定帧率批量刷到 txtLog，控件只保留最近 kMaxLogLines 行
+    ui.txtLog->document()->setMaximumBlockCount(kMaxLogLines);
+    m_logTimer = new QTimer(this);
+    connect(m_logTimer, &QTimer::timeout, this, &WeQQ::flushLogFeed);
+    m_logTimer->start(kLogFlushIntervalMs);
 
     // 连接回车键：在输入框按 Enter -> 触发发送按钮
     connect(ui.editCmd, &QLineEdit::returnPressed, this, &WeQQ::on_btnSend_clicked);
@@ -36,6 +39,44 @@ WeQQ::~WeQQ()
     }
 }
 
+void WeQQ::setDurability(HistoryWriter::Durability mode, int syncIntervalMs)
+{
+    m_serverThread->setDurability(mode, syncIntervalMs);
+}
+
+// =========================================
+// 把后台积攒的日志一次性追加到 txtLog
+// =========================================
+void WeQQ::flushLogFeed()
+{
+    std::vector<std::string> lines;
+    unsigned long long dropped = 0;
+    m_serverThread->logFeed()->take(lines, dropped);
+    if (lines.empty() && dropped == 0) return;
+
+    QString text;
+    if (dropped > 0) {
+        text += "[LogFeed] " + QString::number(dropped) + " lines dropped (too fast to display)\n";
+    }
+    for (const auto& line : lines) {
+        text += QString::fromStdString(line);
+        text += '\n';
+    }
+    text.chop(1);
+
+    // 用户在往上翻看时不强制滚动到底部
+    QScrollBar* bar = ui.txtLog->verticalScrollBar();
+    bool atBottom = (bar->value() == bar->maximum());
+
+    // 纯文本插入：一次排版，也避免聊天内容被当成 HTML 解析
+    QTextCursor cursor(ui.txtLog->document());
+    cursor.movePosition(QTextCursor::End);
+    if (!ui.txtLog->document()->isEmpty()) cursor.insertBlock();
+    cursor.insertText(text);
+
+    if (atBottom) bar->setValue(bar->maximum());
+}
+
 // =========================================
 // 2. 点击“开始运行”按钮
 // =========================================
@@ -80,4 +121,4 @@ void WeQQ::on_btnSend_clicked()
     // 3. 清空输入框
     ui.editCmd->clear();
     ui.editCmd->setFocus();
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <QtWidgets/QWidget>
+#include <QTimer>
 #include "ui_WeQQ.h"
 #include "ServerThread.h" // 【新增1】引入服务器线程的头文件
 
@@ -11,6 +12,9 @@ class WeQQ : public QWidget
 public:
     WeQQ(QWidget* parent = nullptr);
     ~WeQQ();
+
+    // 【新增】启动参数指定的聊天记录落盘方式，需在开始运行之前设置
+    void setDurability(HistoryWriter::Durability mode, int syncIntervalMs);
 private slots:
     // 原有的连接按钮槽函数
     void on_btnConnect_clicked();
@@ -18,9 +22,17 @@ private slots:
     // 【新增2】发送指令按钮的槽函数 (对应你 cpp 里的定义)
     void on_btnSend_clicked();
 
+    // 【新增】定时从 ServerThread 的 LogFeed 取日志刷新到界面
+    void flushLogFeed();
+
 private:
     Ui::WeQQClass ui;
 
     // 【新增3】声明服务器线程指针 (对应报错 E0020)
     ServerThread* m_serverThread;
-};
\ No newline at end of file
+
+    // 【新增】界面日志刷新：约 20 帧/秒，控件最多保留 5000 行
+    static const int kLogFlushIntervalMs = 50;
+    static const int kMaxLogLines = 5000;
+    QTimer* m_logTimer;
+};
\ No newline at end of file
@@ -1,4 +1,4 @@
-# ====================================================================
+﻿# ====================================================================
 # 项目名称：WeQQ Server
 # 功能说明：包含 Qt Network 扩展，支持 VS 和 Qt Creator 双向导入
 # ====================================================================
@@ -23,7 +23,22 @@ SOURCES += \
     User.cpp \
     Group.cpp \
     DataManager.cpp \
-    op.cpp
+    op.cpp \
+    NetEngine.cpp \
+    LineFramer.cpp \
+    LogWriter.cpp \
+    LogFeed.cpp \
+    Session.cpp \
+    MessageId.cpp \
+    HistoryStore.cpp \
+    SeqBitmap.cpp \
+    HistoryCache.cpp \
+    HistoryWriter.cpp \
+    FileHandleCache.cpp \
+    FriendGraph.cpp \
+    RequestStore.cpp \
+    RosterCache.cpp \
+    JournalReader.cpp
 
 # ----------------------------------------------------
 # 3. 头文件 (.h)
@@ -34,7 +49,22 @@ HEADERS += \
     User.h \
     Group.h \
     DataManager.h \
-    op.h
+    op.h \
+    NetEngine.h \
+    LineFramer.h \
+    LogWriter.h \
+    LogFeed.h \
+    Session.h \
+    MessageId.h \
+    HistoryStore.h \
+    SeqBitmap.h \
+    HistoryCache.h \
+    HistoryWriter.h \
+    FileHandleCache.h \
+    FriendGraph.h \
+    RequestStore.h \
+    RosterCache.h \
+    JournalReader.h
 
 # ----------------------------------------------------
 # 4. 界面与资源文件 (.ui / .qrc)
@@ -1,10 +1,29 @@
 ﻿#include "WeQQ.h"
 #include <QtWidgets/QApplication>
+#include <cstring>
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
+
+    // 【新增】聊天记录落盘方式：--durability=none|batched|strict，--fsync-interval=<毫秒> (batched 的合并周期)
+    HistoryWriter::Durability durability = HistoryWriter::DURABILITY_BATCHED;
+    int syncIntervalMs = HistoryWriter::kDefaultSyncIntervalMs;
+    for (const QString& arg : app.arguments().mid(1)) {
+        if (arg.startsWith("--durability=")) {
+            QString mode = arg.mid((int)strlen("--durability="));
+            if (!HistoryWriter::parseDurability(mode.toStdString(), durability)) {
+                qWarning("Unknown durability mode '%s', using batched", qPrintable(mode));
+            }
+        }
+        else if (arg.startsWith("--fsync-interval=")) {
+            int ms = arg.mid((int)strlen("--fsync-interval=")).toInt();
+            if (ms > 0) syncIntervalMs = ms;
+        }
+    }
+
     WeQQ window;
+    window.setDurability(durability, syncIntervalMs);
     window.show();
     return app.exec();
 }
@@ -20,20 +20,19 @@ std::string AdminManager::getUserGroup(std::string username) {
     return GROUP_USER;
 }
 
-void AdminManager::sendSystemMsg(SOCKET sock, string msg) {
-    if (sock != INVALID_SOCKET) {
-        send(sock, msg.c_str(), (int)msg.length(), 0);
+void AdminManager::sendSystemMsg(const SessionPtr& session, string msg) {
+    if (session) {
+        session->send(msg);
     }
 }
 
-void AdminManager::cmdList(SOCKET currentSock, map<string, SOCKET>& onlineUsers, mutex& userMutex) {
+void AdminManager::cmdList(const SessionPtr& current, SessionManager& sessions) {
     string msg = "--- Online Users ---\n";
-    lock_guard<mutex> lock(userMutex);
-    for (auto const& [name, socket] : onlineUsers) {
-        string role = getUserGroup(name);
-        msg += " * " + name + " [" + role + "]\n";
+    for (const SessionPtr& s : sessions.getOnlineSessions()) {
+        string role = getUserGroup(s->getName());
+        msg += " * " + s->getName() + " [" + role + "]\n";
     }
-    sendSystemMsg(currentSock, msg);
+    sendSystemMsg(current, msg);
 }
 
 // ==========================================================
@@ -42,9 +41,8 @@ void AdminManager::cmdList(SOCKET currentSock, map<string, SOCKET>& onlineUsers,
 bool AdminManager::processClientCommand(
     string clientName,
     string rawMsg,
-    SOCKET currentSock,
-    map<string, SOCKET>& onlineUsers,
-    mutex& userMutex,
+    const SessionPtr& current,
+    SessionManager& sessions,
     GroupManager& groupMgr,
     DataManager& userMgr
 )
@@ -59,7 +57,7 @@ bool AdminManager::processClientCommand(
 
     // --- 查看在线人数 (/who) ---
     if (command == "/who") {
-        cmdList(currentSock, onlineUsers, userMutex);
+        cmdList(current, sessions);
         return true;
     }
 
@@ -78,48 +76,42 @@ bool AdminManager::processClientCommand(
             " /op <Name>            - 提升某人为服务器管理员\n"
             " /kick <Name>          - 强制踢某人下线\n"
             " /all <Message>        - 发送全服广播\n";
-        sendSystemMsg(currentSock, msg);
+        sendSystemMsg(current, msg);
         return true;
     }
 
     // --- 添加好友 (/friend_add) ---
     if (command == "/friend_add") {
         if (arg1.empty()) {
-            sendSystemMsg(currentSock, "Usage: /friend_add <ID or Name>\n");
+            sendSystemMsg(current, "Usage: /friend_add <ID or Name>\n");
         }
         else if (arg1 == clientName) {
-            sendSystemMsg(currentSock, "[Error] You cannot add yourself.\n");
+            sendSystemMsg(current, "[Error] You cannot add yourself.\n");
         }
         else {
-            vector<User> all = userMgr.getAllUsers();
-            User* targetUser = nullptr;
-            User* myUser = nullptr;
+            const User* myUser = userMgr.findByName(clientName);
+            const User* targetUser = nullptr;
             int searchId = atoi(arg1.c_str());
 
-            for (auto& u : all) {
-                if (u.getUsername() == clientName) myUser = &u;
-                if (searchId != 0 && u.getId() == searchId) targetUser = &u;
-                else if (targetUser == nullptr && u.getUsername() == arg1) targetUser = &u;
-            }
+            if (searchId != 0) targetUser = userMgr.findById(searchId);
+            if (targetUser == nullptr) targetUser = userMgr.findByName(arg1);
 
             if (targetUser != nullptr) {
                 string packetToMe = "CMD:FRIEND_ADD|" + to_string(targetUser->getId()) + "," + targetUser->getUsername() + "\n";
-                sendSystemMsg(currentSock, packetToMe);
-                sendSystemMsg(currentSock, "[System] Friend added successfully.\n");
+                sendSystemMsg(current, packetToMe);
+                sendSystemMsg(current, "[System] Friend added successfully.\n");
 
                 if (myUser != nullptr) {
-                    lock_guard<mutex> lock(userMutex);
-                    if (onlineUsers.count(targetUser->getUsername())) {
-                        SOCKET targetSock = onlineUsers[targetUser->getUsername()];
+                    if (SessionPtr target = sessions.findById(targetUser->getId())) {
                         string packetToTarget = "CMD:FRIEND_ADD|" + to_string(myUser->getId()) + "," + myUser->getUsername() + "\n";
-                        sendSystemMsg(targetSock, packetToTarget);
+                        sendSystemMsg(target, packetToTarget);
                         string notice = "[System] " + clientName + " added you as friend.\n";
-                        sendSystemMsg(targetSock, notice);
+                        sendSystemMsg(target, notice);
                     }
                 }
             }
             else {
-                sendSystemMsg(currentSock, "[Error] User [" + arg1 + "] not found in server database.\n");
+                sendSystemMsg(current, "[Error] User [" + arg1 + "] not found in server database.\n");
             }
         }
         return true;
@@ -130,25 +122,23 @@ bool AdminManager::processClientCommand(
     if (command == "/op") {
         if (isGlobalAdmin) {
             if (arg1.empty()) {
-                sendSystemMsg(currentSock, "Usage: /op <Username>\n");
+                sendSystemMsg(current, "Usage: /op <Username>\n");
             }
             else {
                 string targetName = arg1;
                 setUserGroup(targetName, GROUP_ADMIN);
-                sendSystemMsg(currentSock, "[System] You granted Admin to [" + targetName + "].\n");
+                sendSystemMsg(current, "[System] You granted Admin to [" + targetName + "].\n");
 
                 // 【核心】对目标用户广播：激活他的“输入指令”按钮
-                lock_guard<mutex> lock(userMutex);
-                if (onlineUsers.count(targetName)) {
-                    SOCKET targetSock = onlineUsers[targetName];
+                if (SessionPtr target = sessions.findByName(targetName)) {
                     string packet = "CMD:GRANT_ADMIN\n"; // 发送激活指令
-                    sendSystemMsg(targetSock, packet);
-                    sendSystemMsg(targetSock, "[System] You have been promoted to Server Admin!\n");
+                    sendSystemMsg(target, packet);
+                    sendSystemMsg(target, "[System] You have been promoted to Server Admin!\n");
                 }
             }
         }
         else {
-            sendSystemMsg(currentSock, "[Permission Denied] Only Admin can use /op.\n");
+            sendSystemMsg(current, "[Permission Denied] Only Admin can use /op.\n");
         }
         return true;
     }
@@ -159,18 +149,17 @@ bool AdminManager::processClientCommand(
 
     if (command == "/g_create") {
         if (arg1.empty()) {
-            sendSystemMsg(currentSock, "Usage: /g_create <GroupName>\n");
+            sendSystemMsg(current, "Usage: /g_create <GroupName>\n");
         }
         else {
             int gid = groupMgr.createGroup(arg1, clientName);
             if (gid == -1) {
-                sendSystemMsg(currentSock, "[Error] Group name '" + arg1 + "' already exists.\n");
+                sendSystemMsg(current, "[Error] Group name '" + arg1 + "' already exists.\n");
             }
             else {
-                groupMgr.save();
-                sendSystemMsg(currentSock, "[Group] Created [" + arg1 + "] successfully! GroupID: " + to_string(gid) + "\n");
+                sendSystemMsg(current, "[Group] Created [" + arg1 + "] successfully! GroupID: " + to_string(gid) + "\n");
                 string listCmd = groupMgr.getGroupListCmd() + "\n";
-                send(currentSock, listCmd.c_str(), (int)listCmd.length(), 0);
+                current->send(listCmd);
             }
         }
         return true;
@@ -178,7 +167,7 @@ bool AdminManager::processClientCommand(
 
     if (command == "/g_join") {
         if (arg1.empty()) {
-            sendSystemMsg(currentSock, "Usage: /g_join <GroupID or GroupName>\n");
+            sendSystemMsg(current, "Usage: /g_join <GroupID or GroupName>\n");
             return true;
         }
 
@@ -196,13 +185,12 @@ bool AdminManager::processClientCommand(
         }
 
         if (joined) {
-            groupMgr.save();
-            sendSystemMsg(currentSock, "[Group] You joined Group " + to_string(gid) + ".\n");
+            sendSystemMsg(current, "[Group] You joined Group " + to_string(gid) + ".\n");
             string listCmd = groupMgr.getGroupListCmd() + "\n";
-            send(currentSock, listCmd.c_str(), (int)listCmd.length(), 0);
+            current->send(listCmd);
         }
         else {
-            sendSystemMsg(currentSock, "[Error] Failed to join (Group full, not exist, or already joined).\n");
+            sendSystemMsg(current, "[Error] Failed to join (Group full, not exist, or already joined).\n");
         }
         return true;
     }
@@ -214,15 +202,14 @@ bool AdminManager::processClientCommand(
 
         if (groupMgr.checkPermission(gid, clientName, ROLE_ADMIN)) {
             if (groupMgr.leaveGroup(gid, target)) {
-                groupMgr.save();
-                sendSystemMsg(currentSock, "[Group] Kicked " + target + ".\n");
+                sendSystemMsg(current, "[Group] Kicked " + target + ".\n");
             }
             else {
-                sendSystemMsg(currentSock, "[Error] Target user is not in this group.\n");
+                sendSystemMsg(current, "[Error] Target user is not in this group.\n");
             }
         }
         else {
-            sendSystemMsg(currentSock, "[Permission Denied] Admin only.\n");
+            sendSystemMsg(current, "[Permission Denied] Admin only.\n");
         }
         return true;
     }
@@ -233,17 +220,15 @@ bool AdminManager::processClientCommand(
 
     if (isGlobalAdmin) {
         if (command == "/kick") {
-            lock_guard<mutex> lock(userMutex);
-            if (onlineUsers.count(arg1)) {
-                SOCKET s = onlineUsers[arg1];
+            if (SessionPtr target = sessions.findByName(arg1)) {
                 string notice = "You have been kicked by Admin.\n";
-                send(s, notice.c_str(), (int)notice.length(), 0);
-                closesocket(s);
-                onlineUsers.erase(arg1);
-                sendSystemMsg(currentSock, "[System] User " + arg1 + " kicked.\n");
+                target->send(notice);
+                // 先把通知发完再关闭，会话由所属 I/O 线程在断开时移除
+                target->close();
+                sendSystemMsg(current, "[System] User " + arg1 + " kicked.\n");
             }
             else {
-                sendSystemMsg(currentSock, "[System] User not found.\n");
+                sendSystemMsg(current, "[System] User not found.\n");
             }
             return true;
         }
@@ -252,16 +237,15 @@ bool AdminManager::processClientCommand(
             size_t pos = rawMsg.find(' ');
             if (pos != string::npos) broadcastMsg = rawMsg.substr(pos + 1);
             if (!broadcastMsg.empty()) {
-                string finalMsg = "\n[Server Broadcast]: " + broadcastMsg + "\n";
-                lock_guard<mutex> lock(userMutex);
-                for (auto const& [name, sock] : onlineUsers) {
-                    send(sock, finalMsg.c_str(), (int)finalMsg.length(), 0);
+                NetEngine::Buffer finalMsg = NetEngine::makeBuffer("\n[Server Broadcast]: " + broadcastMsg + "\n");
+                for (const SessionPtr& s : sessions.getOnlineSessions()) {
+                    s->send(finalMsg);
                 }
             }
             return true;
         }
     }
 
-    sendSystemMsg(currentSock, "[Error] Unknown command. Type /help for list.\n");
+    sendSystemMsg(current, "[Error] Unknown command. Type /help for list.\n");
     return true;
-}
\ No newline at end of file
+}
\ No newline at end of file
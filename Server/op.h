@@ -6,6 +6,7 @@
 #include <winsock2.h> 
 #include "Group.h"    
 #include "DataManager.h" // 【新增】需要访问用户数据来获取ID
+#include "Session.h"     // 【修改】按会话发送与查找在线用户
 
 // ==========================================
 // 全局配置常量
@@ -28,11 +29,10 @@ public:
     static bool processClientCommand(
         std::string clientName,
         std::string rawMsg,
-        SOCKET currentSock,
-        std::map<std::string, SOCKET>& onlineUsers,
-        std::mutex& userMutex,
+        const SessionPtr& current,
+        SessionManager& sessions, // 【修改】在线用户统一由会话表提供
         GroupManager& groupMgr,
-        DataManager& userMgr // 【新增】传入 UserMgr 以便查询所有注册用户
+        DataManager& userMgr  // 【新增】传入 UserMgr 以便查询所有注册用户
     );
 
     // --- 权限管理 (全局权限) ---
@@ -45,14 +45,14 @@ public:
 private:
     // --- 内部辅助函数 ---
 
-    // 发送系统消息 (封装 send)
-    static void sendSystemMsg(SOCKET sock, std::string msg);
+    // 发送系统消息 (封装 Session::send)
+    static void sendSystemMsg(const SessionPtr& session, std::string msg);
 
     // 显示在线用户列表 (/who)
-    static void cmdList(SOCKET currentSock, std::map<std::string, SOCKET>& onlineUsers, std::mutex& userMutex);
+    static void cmdList(const SessionPtr& current, SessionManager& sessions);
 
     // --- 静态数据成员 ---
     // 用来在内存中存储谁是管理员 (简单的 Map)
     static std::map<std::string, std::string> m_userPermissions;
     static std::mutex m_permMutex;
-};
\ No newline at end of file
+};
\ No newline at end of file
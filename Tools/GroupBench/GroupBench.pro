@@ -0,0 +1,21 @@
+# ====================================================================
+# 项目名称：WeQQ GroupBench
+# 功能说明：群组管理多线程压测，统计 1..N 个线程下的吞吐量 (ops/sec)
+# ====================================================================
+
+QT       -= core gui
+CONFIG   += console c++17 thread
+CONFIG   -= app_bundle qt
+TEMPLATE = app
+TARGET   = GroupBench
+
+INCLUDEPATH += ../../Server
+
+SOURCES += \
+    main.cpp \
+    ../../Server/Group.cpp \
+    ../../Server/JournalReader.cpp
+
+HEADERS += \
+    ../../Server/Group.h \
+    ../../Server/JournalReader.h
@@ -0,0 +1,113 @@
+﻿#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include "Group.h"
+
+// ====================================================================
+// 用法：GroupBench [groups] [membersPerGroup] [maxThreads] [--writes=百分比] [--seconds=秒]
+//   默认建 10000 个群、每群 20 人，线程数从 1 倍增到 maxThreads (默认为 CPU 核数)，
+//   每轮每个线程在随机群上反复调用 getGroupName / getUserRole / isMember /
+//   getGroupMembers (成员列表构建时的调用组合)，
+//   --writes 指定其中 join/leave 写操作所占百分比 (默认 0)。
+//   输出每轮的总 ops/sec 以及相对单线程的加速比。
+//   群数据写在当前目录的 GroupBench1.txt / GroupBench2.txt 及其日志。
+// ====================================================================
+
+static const char* kFileBasic = "GroupBench1.txt";
+static const char* kFilePerm = "GroupBench2.txt";
+static std::atomic<size_t> g_sink(0);   // 累加读到的结果，防止读调用被优化掉
+
+static long long runRound(GroupManager& groups, int groupCount, int members, int threadCount, int writePercent, int seconds)
+{
+    std::atomic<bool> stop(false);
+    std::atomic<long long> total(0);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&, t]() {
+            std::mt19937 rng(12345u + (unsigned)t);
+            std::uniform_int_distribution<int> pickGroup(1, groupCount);
+            std::uniform_int_distribution<int> pickMember(0, members - 1);
+            std::uniform_int_distribution<int> pickPercent(0, 99);
+            std::string guest = "guest" + std::to_string(t);
+            long long ops = 0;
+            size_t sink = 0;
+
+            while (!stop.load(std::memory_order_relaxed)) {
+                int gid = pickGroup(rng);
+                std::string name = "u" + std::to_string(gid) + "_" + std::to_string(pickMember(rng));
+                if (writePercent > 0 && pickPercent(rng) < writePercent) {
+                    if (groups.isMember(gid, guest)) groups.leaveGroup(gid, guest);
+                    else groups.joinGroup(gid, guest);
+                }
+                else {
+                    sink += groups.getGroupName(gid).size();
+                    sink += groups.getUserRole(gid, name);
+                    sink += groups.isMember(gid, name) ? 1 : 0;
+                    sink += groups.getGroupMembers(gid).size();
+                }
+                ops++;
+            }
+            total += ops;
+            g_sink += sink;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop = true;
+    for (std::thread& w : workers) w.join();
+    return total / seconds;
+}
+
+int main(int argc, char* argv[])
+{
+    int groupCount = 10000;
+    int members = 20;
+    int maxThreads = (int)std::thread::hardware_concurrency();
+    int writePercent = 0;
+    int seconds = 2;
+
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a.rfind("--writes=", 0) == 0) writePercent = std::stoi(a.substr(9));
+        else if (a.rfind("--seconds=", 0) == 0) seconds = std::stoi(a.substr(10));
+        else args.push_back(a);
+    }
+    if (args.size() >= 1) groupCount = std::stoi(args[0]);
+    if (args.size() >= 2) members = std::stoi(args[1]);
+    if (args.size() >= 3) maxThreads = std::stoi(args[2]);
+    if (maxThreads < 1) maxThreads = 1;
+    if (members < 1) members = 1;
+    if (seconds < 1) seconds = 1;
+
+    std::remove(kFileBasic);
+    std::remove(kFilePerm);
+    std::remove((std::string(kFileBasic) + ".journal").c_str());
+
+    GroupManager groups(kFileBasic, kFilePerm);
+    for (int g = 1; g <= groupCount; ++g) {
+        int gid = groups.createGroup("group" + std::to_string(g), "u" + std::to_string(g) + "_0");
+        for (int m = 1; m < members; ++m) groups.joinGroup(gid, "u" + std::to_string(gid) + "_" + std::to_string(m));
+        groups.setUserRole(gid, "u" + std::to_string(gid) + "_1", ROLE_ADMIN);
+    }
+    std::cout << ">>> Groups: " << groupCount << " x " << members << " members"
+              << ", shards: " << GroupManager::kShardCount
+              << ", writes: " << writePercent << "%" << std::endl;
+
+    long long base = 0;
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > maxThreads) threads = maxThreads;
+        long long opsPerSec = runRound(groups, groupCount, members, threads, writePercent, seconds);
+        if (base == 0) base = opsPerSec;
+        std::cout << ">>> Threads: " << threads << ", ops/sec: " << opsPerSec
+                  << ", speedup: " << (base > 0 ? (double)opsPerSec / base : 0.0) << "x" << std::endl;
+        if (threads == maxThreads) break;
+    }
+    return 0;
+}
@@ -0,0 +1,15 @@
+# ====================================================================
+# 项目名称：WeQQ LoadGen
+# 功能说明：本机回环压测工具，批量建立空闲连接以验证服务器连接引擎
+# ====================================================================
+
+QT       -= core gui
+CONFIG   += console c++17
+CONFIG   -= app_bundle qt
+TEMPLATE = app
+TARGET   = LoadGen
+
+win32: LIBS += -lws2_32
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,81 @@
+﻿#include <winsock2.h>
+#include <WS2tcpip.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#pragma comment(lib,"ws2_32.lib")
+
+// ====================================================================
+// 用法：LoadGen [ip] [port] [count] [--login]
+//   默认向 127.0.0.1:9870 建立 20000 个空闲连接并保持，按回车释放。
+//   --login 时每个连接发送一次 CMD:LOGIN|lg<N>|lg 完成注册/登录。
+// 注意：Windows 默认动态端口范围约 16k，超过时需先执行
+//   netsh int ipv4 set dynamicport tcp start=10000 num=55000
+// ====================================================================
+
+int main(int argc, char* argv[])
+{
+    std::string ip = "127.0.0.1";
+    int port = 9870;
+    int count = 20000;
+    bool doLogin = false;
+
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--login") doLogin = true;
+        else args.push_back(a);
+    }
+    if (args.size() >= 1) ip = args[0];
+    if (args.size() >= 2) port = std::stoi(args[1]);
+    if (args.size() >= 3) count = std::stoi(args[2]);
+
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        std::cout << "WSAStartup failed." << std::endl;
+        return 1;
+    }
+
+    SOCKADDR_IN addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, ip.c_str(), &addr.sin_addr);
+
+    std::vector<SOCKET> socks;
+    socks.reserve(count);
+    int failed = 0;
+    auto begin = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < count; ++i) {
+        SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+        if (s == INVALID_SOCKET) { failed++; continue; }
+
+        if (connect(s, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+            int err = WSAGetLastError();
+            closesocket(s);
+            failed++;
+            if (failed == 1) std::cout << "connect failed, WSA error " << err << std::endl;
+            continue;
+        }
+
+        if (doLogin) {
+            std::string packet = "CMD:LOGIN|lg" + std::to_string(i) + "|lg\n";
+            send(s, packet.c_str(), (int)packet.length(), 0);
+        }
+        socks.push_back(s);
+
+        if ((i + 1) % 1000 == 0) {
+            std::cout << "  " << (i + 1) << " / " << count << std::endl;
+        }
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << ">>> Connected: " << socks.size() << ", failed: " << failed << ", time: " << ms << " ms" << std::endl;
+    std::cout << ">>> Holding connections, press Enter to release..." << std::endl;
+    std::cin.get();
+
+    for (SOCKET s : socks) closesocket(s);
+    WSACleanup();
+    return 0;
+}
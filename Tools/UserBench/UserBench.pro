@@ -0,0 +1,23 @@
+# ====================================================================
+# 项目名称：WeQQ UserBench
+# 功能说明：用户库注册压测，统计批量注册的耗时与写盘字节数
+# ====================================================================
+
+QT       -= core gui
+CONFIG   += console c++17
+CONFIG   -= app_bundle qt
+TEMPLATE = app
+TARGET   = UserBench
+
+INCLUDEPATH += ../../Server
+
+SOURCES += \
+    main.cpp \
+    ../../Server/DataManager.cpp \
+    ../../Server/JournalReader.cpp \
+    ../../Server/User.cpp
+
+HEADERS += \
+    ../../Server/DataManager.h \
+    ../../Server/JournalReader.h \
+    ../../Server/User.h
@@ -0,0 +1,74 @@
+﻿#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include "DataManager.h"
+
+// ====================================================================
+// 用法：UserBench [count] [--rewrite]
+//   默认在当前目录的 UserBench.txt 中注册 100000 个用户，
+//   输出注册耗时、写盘字节数以及重新加载 (快照 + 日志重放) 的耗时。
+//   --rewrite 模拟旧版行为：每注册一个用户就整表重写一次，
+//   数量级为 O(N^2)，建议配合较小的 count 对比。
+// ====================================================================
+
+static long long elapsedMs(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char* argv[])
+{
+    int count = 100000;
+    bool rewrite = false;
+
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--rewrite") rewrite = true;
+        else args.push_back(a);
+    }
+    if (args.size() >= 1) count = std::stoi(args[0]);
+
+    const std::string file = "UserBench.txt";
+    std::remove(file.c_str());
+    std::remove((file + ".journal").c_str());
+    std::remove((file + ".tmp").c_str());
+
+    unsigned long long bytes = 0;
+    auto begin = std::chrono::steady_clock::now();
+    {
+        DataManager users(file, TYPE_USER);
+        if (rewrite) users.setAutoSave(false);
+
+        for (int i = 0; i < count; ++i) {
+            int id = users.getNextId();
+            users.addUser(User(id, "bench" + std::to_string(i), "pwd" + std::to_string(i), "127.0.0.1"));
+            if (rewrite) users.save();
+
+            if ((i + 1) % 10000 == 0) {
+                std::cout << "  " << (i + 1) << " / " << count << std::endl;
+            }
+        }
+        bytes = users.getBytesWritten();
+        users.setAutoSave(false); // 不把析构时的压缩算进注册耗时
+    }
+    long long registerMs = elapsedMs(begin);
+
+    begin = std::chrono::steady_clock::now();
+    size_t loaded = 0;
+    {
+        DataManager users(file, TYPE_USER);
+        users.setAutoSave(false);
+        loaded = users.getUserCount();
+    }
+    long long loadMs = elapsedMs(begin);
+
+    std::cout << ">>> Mode: " << (rewrite ? "rewrite" : "journal") << std::endl;
+    std::cout << ">>> Registered: " << count << ", time: " << registerMs << " ms"
+              << ", bytes written: " << bytes
+              << " (" << (count > 0 ? bytes / (unsigned long long)count : 0) << " B/user)" << std::endl;
+    std::cout << ">>> Reloaded: " << loaded << " users, time: " << loadMs << " ms" << std::endl;
+    return loaded == (size_t)count ? 0 : 1;
+}